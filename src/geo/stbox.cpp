@@ -190,6 +190,36 @@ void StboxType::RegisterScalarFunctions(DatabaseInstance &instance) {
             StboxFunctions::Contains_stbox_stbox
         )
     );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "<@", // contained
+            {STBOX(), STBOX()},
+            LogicalType::BOOLEAN,
+            StboxFunctions::Contained_stbox_stbox
+        )
+    );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "<->", // nearest approach distance
+            {STBOX(), STBOX()},
+            LogicalType::DOUBLE,
+            StboxFunctions::Nad_stbox_stbox
+        )
+    );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "nearestApproachDistance",
+            {STBOX(), STBOX()},
+            LogicalType::DOUBLE,
+            StboxFunctions::Nad_stbox_stbox
+        )
+    );
 }
 
 } // namespace duckdb
\ No newline at end of file
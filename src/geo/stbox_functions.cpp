@@ -603,4 +603,72 @@ void StboxFunctions::Contains_stbox_stbox(DataChunk &args, ExpressionState &stat
     }
 }
 
+void StboxFunctions::Contained_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::Execute<string_t, string_t, bool>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t input_stbox1, string_t input_stbox2) -> bool {
+            const uint8_t *data1 = reinterpret_cast<const uint8_t*>(input_stbox1.GetData());
+            size_t data_size1 = input_stbox1.GetSize();
+            const uint8_t *data2 = reinterpret_cast<const uint8_t*>(input_stbox2.GetData());
+            size_t data_size2 = input_stbox2.GetSize();
+            if (data_size1 < sizeof(STBox) || data_size2 < sizeof(STBox)) {
+                throw InvalidInputException("Invalid STBOX data: insufficient size");
+            }
+
+            // The blob data is not guaranteed to be aligned
+            uint8_t *data_copy1 = (uint8_t*)malloc(data_size1);
+            memcpy(data_copy1, data1, data_size1);
+            uint8_t *data_copy2 = (uint8_t*)malloc(data_size2);
+            memcpy(data_copy2, data2, data_size2);
+
+            bool ret = contained_stbox_stbox(reinterpret_cast<STBox*>(data_copy1),
+                                             reinterpret_cast<STBox*>(data_copy2));
+            free(data_copy1);
+            free(data_copy2);
+            return ret;
+        }
+    );
+    if (args.size() == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+/* ***************************************************
+ * Distance operators
+ ****************************************************/
+
+void StboxFunctions::Nad_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::Execute<string_t, string_t, double>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t input_stbox1, string_t input_stbox2) -> double {
+            const uint8_t *data1 = reinterpret_cast<const uint8_t*>(input_stbox1.GetData());
+            size_t data_size1 = input_stbox1.GetSize();
+            if (data_size1 < sizeof(STBox)) {
+                throw InvalidInputException("Invalid STBOX data: insufficient size");
+            }
+            uint8_t *data_copy1 = (uint8_t*)malloc(data_size1);
+            memcpy(data_copy1, data1, data_size1);
+            STBox *stbox1 = reinterpret_cast<STBox*>(data_copy1);
+
+            const uint8_t *data2 = reinterpret_cast<const uint8_t*>(input_stbox2.GetData());
+            size_t data_size2 = input_stbox2.GetSize();
+            if (data_size2 < sizeof(STBox)) {
+                free(stbox1);
+                throw InvalidInputException("Invalid STBOX data: insufficient size");
+            }
+            uint8_t *data_copy2 = (uint8_t*)malloc(data_size2);
+            memcpy(data_copy2, data2, data_size2);
+            STBox *stbox2 = reinterpret_cast<STBox*>(data_copy2);
+
+            double ret = nad_stbox_stbox(stbox1, stbox2);
+            free(stbox1);
+            free(stbox2);
+            return ret;
+        }
+    );
+    if (args.size() == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
 } // namespace duckdb
\ No newline at end of file
@@ -272,6 +272,16 @@ void TgeompointType::RegisterScalarFunctions(DatabaseInstance &instance) {
         )
     );
 
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "atStbox",
+            {TGEOMPOINT(), StboxType::STBOX()},
+            TGEOMPOINT(),
+            TgeompointFunctions::Tgeo_at_stbox
+        )
+    );
+
     /* ***************************************************
      * Spatial relationships
      ****************************************************/
@@ -344,6 +354,16 @@ void TgeompointType::RegisterScalarFunctions(DatabaseInstance &instance) {
         )
     );
 
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "<@", // contained
+            {TGEOMPOINT(), StboxType::STBOX()},
+            LogicalType::BOOLEAN,
+            TgeompointFunctions::Temporal_contained_tgeompoint_stbox
+        )
+    );
+
      /* ***************************************************
      * Distance function
      ****************************************************/
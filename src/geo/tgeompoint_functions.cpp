@@ -603,6 +603,45 @@ void TgeompointFunctions::Tgeo_at_geom(DataChunk &args, ExpressionState &state,
     }
 }
 
+void TgeompointFunctions::Tgeo_at_stbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::ExecuteWithNulls<string_t, string_t, string_t>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t tgeom_blob, string_t stbox_blob, ValidityMask &mask, idx_t idx) -> string_t {
+            const uint8_t *tgeom_data = reinterpret_cast<const uint8_t*>(tgeom_blob.GetData());
+            size_t tgeom_data_size = tgeom_blob.GetSize();
+            uint8_t *tgeom_data_copy = (uint8_t*)malloc(tgeom_data_size);
+            memcpy(tgeom_data_copy, tgeom_data, tgeom_data_size);
+            Temporal *tgeom = reinterpret_cast<Temporal*>(tgeom_data_copy);
+            if (!tgeom) {
+                free(tgeom_data_copy);
+                throw InvalidInputException("Invalid TGEOMPOINT data: null pointer");
+            }
+
+            if (stbox_blob.GetSize() < sizeof(STBox)) {
+                free(tgeom);
+                throw InvalidInputException("Invalid STBOX data: insufficient size");
+            }
+            STBox stbox;
+            memcpy(&stbox, stbox_blob.GetData(), sizeof(STBox));
+
+            // Like MobilityDB, the border of the box belongs to the box
+            Temporal *ret = tgeo_at_stbox(tgeom, &stbox, true);
+            free(tgeom);
+            if (!ret) {
+                mask.SetInvalid(idx);
+                return string_t();
+            }
+            size_t ret_size = temporal_mem_size(ret);
+            string_t stored_data = StringVector::AddStringOrBlob(result, reinterpret_cast<const char*>(ret), ret_size);
+            free(ret);
+            return stored_data;
+        }
+    );
+    if (args.size() == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
 /* ***************************************************
  * Spatial relationships
  ****************************************************/
@@ -842,6 +881,40 @@ void TgeompointFunctions::Temporal_contains_tgeompoint_stbox(DataChunk &args, Ex
     }
 }
 
+void TgeompointFunctions::Temporal_contained_tgeompoint_stbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::Execute<string_t, string_t, bool>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t tgeom_blob, string_t stbox_blob) -> bool {
+            const uint8_t *tgeom_data = reinterpret_cast<const uint8_t*>(tgeom_blob.GetData());
+            size_t tgeom_data_size = tgeom_blob.GetSize();
+            uint8_t *tgeom_data_copy = (uint8_t*)malloc(tgeom_data_size);
+            memcpy(tgeom_data_copy, tgeom_data, tgeom_data_size);
+            Temporal *tgeom = reinterpret_cast<Temporal*>(tgeom_data_copy);
+            if (!tgeom) {
+                free(tgeom_data_copy);
+                throw InvalidInputException("Invalid TGEOMPOINT data: null pointer");
+            }
+
+            const uint8_t *stbox_data = reinterpret_cast<const uint8_t*>(stbox_blob.GetData());
+            size_t stbox_data_size = stbox_blob.GetSize();
+            uint8_t *stbox_data_copy = (uint8_t*)malloc(stbox_data_size);
+            memcpy(stbox_data_copy, stbox_data, stbox_data_size);
+            STBox *stbox = reinterpret_cast<STBox*>(stbox_data_copy);
+            if (!stbox) {
+                free(stbox_data_copy);
+                throw InvalidInputException("Invalid STBOX data: null pointer");
+            }
+            bool ret = contained_tspatial_stbox(tgeom, stbox);
+            free(tgeom);
+            free(stbox);
+            return ret;
+        }
+    );
+    if (args.size() == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
 /* ***************************************************
  * Distance function
  ****************************************************/
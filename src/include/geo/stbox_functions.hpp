@@ -76,6 +76,12 @@ struct StboxFunctions {
      ****************************************************/
     static void Overlaps_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result);
     static void Contains_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contained_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result);
+
+    /* ***************************************************
+     * Distance operators
+     ****************************************************/
+    static void Nad_stbox_stbox(DataChunk &args, ExpressionState &state, Vector &result);
 };
 
 }
\ No newline at end of file
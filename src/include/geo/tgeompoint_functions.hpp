@@ -55,6 +55,7 @@ struct TgeompointFunctions {
     static void Tpoint_trajectory(DataChunk &args, ExpressionState &state, Vector &result);
     // static void Tpoint_trajectory_gs(DataChunk &args, ExpressionState &state, Vector &result);
     static void Tgeo_at_geom(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Tgeo_at_stbox(DataChunk &args, ExpressionState &state, Vector &result);
 
     /* ***************************************************
      * Spatial relationships
@@ -73,6 +74,7 @@ struct TgeompointFunctions {
     static void Temporal_overlaps_tgeompoint_stbox(DataChunk &args, ExpressionState &state, Vector &result);
     static void Temporal_overlaps_tgeompoint_tstzspan(DataChunk &args, ExpressionState &state, Vector &result);
     static void Temporal_contains_tgeompoint_stbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Temporal_contained_tgeompoint_stbox(DataChunk &args, ExpressionState &state, Vector &result);
 
     /* ***************************************************
      * Distance function
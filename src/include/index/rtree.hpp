@@ -0,0 +1,387 @@
+#pragma once
+
+#include "meos_wrapper_simple.hpp"
+
+#include "duckdb/common/common.hpp"
+#include "duckdb/common/map.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/common/unordered_set.hpp"
+#include "duckdb/common/types/string_type.hpp"
+#include "duckdb/execution/index/fixed_size_allocator.hpp"
+#include "duckdb/execution/index/index_pointer.hpp"
+
+#include <deque>
+#include <queue>
+
+namespace duckdb {
+
+//------------------------------------------------------------------------------
+// RTreeBounds
+//------------------------------------------------------------------------------
+//! Axis-aligned box stored in the R-tree nodes. A dimension that the source STBox
+//! does not have is stored as the unbounded range, so it never prunes a search.
+//! Time bounds are inclusive microseconds; exclusive STBox bounds are tightened by one tick.
+//! The value range of a TBox is stored on the X axis.
+struct RTreeBounds {
+    double xmin, ymin, zmin;
+    double xmax, ymax, zmax;
+    int64_t tmin, tmax;
+
+    //! Axes used for ordering entries
+    static constexpr idx_t AXIS_X = 0;
+    static constexpr idx_t AXIS_Y = 1;
+    static constexpr idx_t AXIS_Z = 2;
+    static constexpr idx_t AXIS_T = 3;
+    static constexpr idx_t AXIS_COUNT = 4;
+
+    //! The inverted box, neutral element of Union
+    static RTreeBounds Empty();
+    //! The box covering everything
+    static RTreeBounds Unbounded();
+    static RTreeBounds FromSTBox(const STBox &box);
+    //! The value range, inclusive also where the TBox bound is not, and the period
+    static RTreeBounds FromTBox(const TBox &box);
+    //! Read an STBOX blob, returns false if the blob is not a valid STBOX
+    static bool FromBlob(const string_t &blob, RTreeBounds &result);
+
+    bool Intersects(const RTreeBounds &other) const;
+    bool Contains(const RTreeBounds &other) const;
+    void Union(const RTreeBounds &other);
+
+    //! Whether the axis has a finite extent
+    bool HasAxis(idx_t axis) const;
+    double Center(idx_t axis) const;
+    //! Product of the finite extents
+    double Area() const;
+    //! Sum of the finite extents
+    double Margin() const;
+    //! Lower bound of the nearest approach distance of anything inside the boxes, in the spatial axes both
+    //! boxes have. Boxes that both have a time axis without a common instant are infinitely far apart.
+    double MinDistance(const RTreeBounds &other) const;
+};
+
+//------------------------------------------------------------------------------
+// RTreeEntry / RTreeNode
+//------------------------------------------------------------------------------
+struct RTreeEntry {
+    RTreeEntry() = default;
+    RTreeEntry(const RTreeBounds &bounds_p, idx_t data_p) : bounds(bounds_p), data(data_p) {
+    }
+
+    RTreeBounds bounds;
+    //! The row id in a leaf, the serialized IndexPointer of the child in a branch
+    idx_t data;
+};
+
+//! A node is a single fixed-size segment of the node allocator. The entries are stored column-wise, one array
+//! per coordinate, so that the bounds of all entries are compared against a query box in a few vector
+//! instructions.
+struct RTreeNode {
+    static constexpr uint32_t CAPACITY = 64;
+    //! A node that drops below this many entries after a delete is dissolved and its entries reinserted
+    static constexpr uint32_t MIN_FILL = CAPACITY / 4;
+
+    //! Height above the leaves, 0 for leaves
+    uint32_t level;
+    uint32_t count;
+    double xmin[CAPACITY];
+    double ymin[CAPACITY];
+    double zmin[CAPACITY];
+    double xmax[CAPACITY];
+    double ymax[CAPACITY];
+    double zmax[CAPACITY];
+    int64_t tmin[CAPACITY];
+    int64_t tmax[CAPACITY];
+    //! The row id in a leaf, the serialized IndexPointer of the child in a branch
+    idx_t data[CAPACITY];
+
+    bool IsLeaf() const {
+        return level == 0;
+    }
+    RTreeBounds GetBounds() const;
+    RTreeBounds GetEntryBounds(idx_t idx) const;
+    void SetEntryBounds(idx_t idx, const RTreeBounds &bounds);
+    RTreeEntry GetEntry(idx_t idx) const {
+        return RTreeEntry(GetEntryBounds(idx), data[idx]);
+    }
+    void SetEntry(idx_t idx, const RTreeEntry &entry) {
+        SetEntryBounds(idx, entry.bounds);
+        data[idx] = entry.data;
+    }
+    void Append(const RTreeEntry &entry) {
+        SetEntry(count++, entry);
+    }
+    //! Replace the entry with the last one
+    void Remove(idx_t idx) {
+        SetEntry(idx, GetEntry(--count));
+    }
+    //! Copy the entries out, in order
+    vector<RTreeEntry> GetEntries() const;
+    //! Replace all entries
+    void SetEntries(const RTreeEntry *entries, idx_t entry_count);
+
+    //! Bitmask of the entries whose bounds intersect the query, bit i for entry i. Runs the widest kernel the
+    //! CPU supports, see rtree_kernels.cpp.
+    uint64_t Intersecting(const RTreeBounds &query) const;
+};
+
+//! The vector kernel RTreeNode::Intersecting runs on this CPU: "avx512", "avx2" or "scalar"
+const char *RTreeKernelName();
+
+//! Relation between an indexed box and the query box that a scan looks for
+enum class RTreePredicate : uint8_t {
+    //! The boxes share a point, `&&`
+    OVERLAPS,
+    //! The indexed box contains the query, `@>`
+    CONTAINS,
+    //! The indexed box is contained in the query, `<@`
+    CONTAINED_BY
+};
+
+class TRTree;
+
+//! Keeps the nodes a cursor can reach from being changed in place or freed while it is held. Writers copy
+//! such a node before changing it and free the original once every snapshot that could reach it is released.
+class RTreeSnapshot {
+public:
+    RTreeSnapshot(const TRTree &tree, idx_t epoch) : tree(tree), epoch(epoch) {
+    }
+    ~RTreeSnapshot();
+
+private:
+    const TRTree &tree;
+    idx_t epoch;
+};
+
+//! Resumable depth-first traversal of the tree for one query box
+struct RTreeCursor {
+    struct Frame {
+        IndexPointer node;
+        //! Entries of the node that match the query and were not visited yet
+        uint64_t pending;
+    };
+
+    RTreeBounds query;
+    RTreePredicate predicate = RTreePredicate::OVERLAPS;
+    vector<Frame> stack;
+    //! The tree as it was when the cursor was positioned, released once the cursor is exhausted
+    unique_ptr<RTreeSnapshot> snapshot;
+
+    bool IsExhausted() const {
+        return stack.empty();
+    }
+};
+
+//! Resumable depth-first traversal of the tree for many query boxes at once. Every node is visited once,
+//! carrying the queries whose boxes intersect it.
+struct RTreeBatchCursor {
+    struct Frame {
+        IndexPointer node;
+        //! Next child to descend into, in a branch
+        uint32_t next_entry;
+        //! Position in the active queries of the query being emitted, in a leaf
+        uint32_t next_query;
+        //! Indexes of the queries that intersect the node
+        vector<uint32_t> active;
+        //! For each active query the entries of the node it intersects, computed on the first visit.
+        //! A leaf clears the entries it has emitted.
+        vector<uint64_t> hits;
+    };
+
+    vector<RTreeBounds> queries;
+    vector<Frame> stack;
+    unique_ptr<RTreeSnapshot> snapshot;
+
+    bool IsExhausted() const {
+        return stack.empty();
+    }
+};
+
+//! Best-first traversal of the tree in increasing distance to one query box
+struct RTreeNearestCursor {
+    struct Candidate {
+        double distance;
+        //! The row id of a leaf entry, or the serialized IndexPointer of a node
+        idx_t data;
+        bool is_row;
+
+        bool operator>(const Candidate &other) const {
+            return distance > other.distance;
+        }
+    };
+
+    RTreeBounds query;
+    std::priority_queue<Candidate, vector<Candidate>, std::greater<Candidate>> queue;
+    unique_ptr<RTreeSnapshot> snapshot;
+
+    bool IsExhausted() const {
+        return queue.empty();
+    }
+};
+
+//! Structural health of a tree
+struct RTreeStats {
+    //! Number of nodes on each level, leaves first. The height is the number of levels.
+    vector<idx_t> level_nodes;
+    idx_t node_count = 0;
+    //! Number of leaf entries
+    idx_t entry_count = 0;
+    //! Fraction of the entry slots of all nodes that hold an entry
+    double fill = 0;
+    //! Mean over the nodes of the fraction of their box that none of their entry boxes covers. A search
+    //! box falling there reads the node for nothing. Nodes whose box has no extent are left out.
+    double dead_space = 0;
+    //! Mean over the parents of leaves of the fraction of their box that pairs of sibling leaves share,
+    //! summed over the pairs. Each axis is measured relative to the extent of the parent on that axis, so
+    //! the time and space axes give a fraction without units. A search box falling there descends into
+    //! more than one leaf.
+    double leaf_overlap = 0;
+};
+
+//------------------------------------------------------------------------------
+// TRTree
+//------------------------------------------------------------------------------
+//! Extension-owned R-tree over RTreeBounds. Nodes live in a FixedSizeAllocator.
+class TRTree {
+public:
+    //! Tag of every node pointer, so that the first segment of the first buffer is not the null pointer
+    static constexpr uint8_t NODE_METADATA = 1;
+    //! Most nodes copied to measure the dead space and leaf overlap
+    static constexpr idx_t STATS_SAMPLE_NODES = 256;
+
+    explicit TRTree(BlockManager &block_manager);
+
+    IndexPointer &GetRoot() {
+        return root;
+    }
+    FixedSizeAllocator &GetAllocator() {
+        return *allocator;
+    }
+    bool IsEmpty() const {
+        return !root;
+    }
+
+    //! Pin a node for modification, this marks its buffer dirty
+    RTreeNode &GetNode(const IndexPointer ptr) const;
+    //! Pin a node for reading without marking its buffer dirty, so that a checkpoint does not rewrite buffers
+    //! that were only read. The allocator keeps a buffer pinned from its first access on, reading does not let
+    //! the buffer manager evict it. Safe to call from several readers at once.
+    const RTreeNode &GetNodeReadOnly(const IndexPointer ptr) const;
+    //! Memory held by the node buffers that are loaded
+    idx_t GetInMemorySize() const;
+
+    //! Insert a single leaf entry
+    void Insert(const RTreeBounds &bounds, row_t row_id);
+    //! Remove the leaf entry with exactly these bounds and row id, condensing underfull nodes.
+    //! Returns false if there is no such entry.
+    bool Delete(const RTreeBounds &bounds, row_t row_id);
+    //! Pack the entries bottom-up into full nodes using Sort-Tile-Recursive ordering.
+    //! Entries of a level above 0 point to nodes of this tree one level below.
+    //! The tree must be empty; the entries are reordered and consumed.
+    void BulkLoad(vector<RTreeEntry> &entries, uint32_t level = 0);
+    //! Pack one level of entries into full nodes, returns the entries of the new nodes
+    vector<RTreeEntry> PackLevel(vector<RTreeEntry> &entries, uint32_t level);
+    //! Take over all nodes of the other tree that are reachable from the entries.
+    //! The entries are rewritten to point into this tree.
+    void MergeNodes(TRTree &other, vector<RTreeEntry> &entries);
+    //! Take over all entries of the other tree, which is left empty. The leaf nodes of the lower tree are
+    //! reinserted into the taller one, nearly empty leaves entry by entry.
+    void Merge(TRTree &other);
+    //! Append the row ids of all leaf entries intersecting the query
+    void Search(const RTreeBounds &query, vector<row_t> &result) const;
+    //! Position the cursor before the first entry matching the query.
+    //! Like the MEOS box operators, containment only compares the axes both boxes have.
+    void InitializeScan(RTreeCursor &cursor, const RTreeBounds &query,
+                        RTreePredicate predicate = RTreePredicate::OVERLAPS) const;
+    //! Emit up to capacity further row ids of the cursor, returns the number written
+    idx_t Scan(RTreeCursor &cursor, row_t *result, idx_t capacity) const;
+    //! Whether a leaf entry matches the query of the cursor, a missing axis of the leaf box is not compared
+    static bool MatchesLeaf(const RTreeBounds &bounds, const RTreeCursor &cursor);
+    //! Position the cursor before the first (query, leaf entry) pair that intersect
+    void InitializeBatchScan(RTreeBatchCursor &cursor, vector<RTreeBounds> queries) const;
+    //! Emit up to capacity further intersecting pairs as query indexes and row ids, returns the number written
+    idx_t BatchScan(RTreeBatchCursor &cursor, uint32_t *query_ids, row_t *row_ids, idx_t capacity) const;
+    //! Position the cursor before the entry nearest to the query
+    void InitializeNearestScan(RTreeNearestCursor &cursor, const RTreeBounds &query) const;
+    //! Emit up to capacity further row ids of the cursor in increasing distance to the query
+    idx_t NearestScan(RTreeNearestCursor &cursor, row_t *result, idx_t capacity) const;
+    //! Estimate the number of leaf entries intersecting the query. Up to node_budget nodes are read
+    //! breadth-first; the subtrees below them are assumed to be filled like the nodes read so far
+    //! and to be hit in proportion to their overlap with the query.
+    double EstimateCount(const RTreeBounds &query, idx_t node_budget) const;
+    //! Free all nodes, those an open snapshot can reach once it is released
+    void Reset();
+    //! Free the nodes replaced by writers that no open snapshot can reach anymore. Called by writers, which
+    //! hold the tree exclusively.
+    void ReleaseRetired();
+    //! Number of replaced nodes that are still allocated for open snapshots
+    idx_t GetRetiredCount() const;
+    bool HasOpenSnapshots() const;
+    //! Fraction of the entry slots of all nodes that hold no entry
+    double GetEmptySlots() const;
+    //! Walk the whole tree and gather its counts. Up to STATS_SAMPLE_NODES nodes, spread evenly over the
+    //! walk, are copied into the sample if one is given.
+    RTreeStats GetStats(optional_ptr<vector<RTreeNode>> sample = nullptr) const;
+    //! Measure the dead space and leaf overlap of the stats on sampled nodes, without reading the tree
+    static void MeasureSample(const vector<RTreeNode> &sample, RTreeStats &stats);
+    //! Rebuild the tree from its leaf entries into full nodes
+    void Repack();
+
+    //! Check the structural invariants, throws an InternalException on violation. Returns the node count.
+    idx_t Verify() const;
+    //! Height, node and entry counts; with a node per line for small trees unless only the summary is wanted
+    string ToString(bool summary_only) const;
+
+    //! Order the entries so that consecutive runs of CAPACITY entries are spatially close
+    static void SortTileRecursive(vector<RTreeEntry> &entries);
+    //! The axes on which any of the entries is bounded, X alone if none is
+    static vector<idx_t> GetActiveAxes(const RTreeEntry *begin, const RTreeEntry *end);
+
+private:
+    friend class RTreeSnapshot;
+
+    IndexPointer NewNode(uint32_t level);
+    //! Free the node, or retire it if an open snapshot can reach it
+    void FreeNode(IndexPointer ptr);
+    //! The node itself if no open snapshot can reach it, otherwise a copy replacing it. The caller links the
+    //! returned node into its parent.
+    IndexPointer CopyOnWrite(IndexPointer ptr);
+    //! Take a snapshot of the tree for a cursor, under a shared key of its index
+    unique_ptr<RTreeSnapshot> OpenSnapshot() const;
+    void CloseSnapshot(idx_t epoch) const;
+    //! Insert the entry into a node of the given level, growing the tree if the root is split
+    void InsertEntry(const RTreeEntry &entry, uint32_t level);
+    //! Insert the entry into the subtree at the given level, returns true if the node was split. The node
+    //! pointer is replaced if the node had to be copied.
+    bool InsertRecursive(IndexPointer &node_ptr, const RTreeEntry &entry, uint32_t level, RTreeEntry &split);
+    //! Remove the leaf entry from the subtree, returns true if it was found. The entries of dissolved
+    //! nodes are collected with the level they have to be reinserted at. The node pointer is replaced if the
+    //! node had to be copied.
+    bool DeleteRecursive(IndexPointer &node_ptr, const RTreeEntry &entry,
+                         vector<pair<uint32_t, RTreeEntry>> &orphans);
+    //! Split the full node, adding the overflow entry. Returns the entry of the new sibling
+    RTreeEntry SplitNode(IndexPointer node_ptr, const RTreeEntry &overflow);
+    //! Free the branch nodes of the subtree, collecting the entries of its leaf nodes
+    void DissolveBranches(IndexPointer node_ptr, vector<RTreeEntry> &leaf_nodes);
+    //! Shift the buffer ids of all child pointers below the node
+    void RebaseNodes(IndexPointer node_ptr, idx_t buffer_offset);
+    idx_t VerifyNode(IndexPointer node_ptr, uint32_t expected_level, const RTreeBounds *parent_bounds) const;
+
+private:
+    IndexPointer root;
+    unique_ptr<FixedSizeAllocator> allocator;
+    //! Serializes the buffer pins of concurrent readers, the allocator loads a buffer on its first pin
+    mutable mutex pin_lock;
+
+    //! Guards the snapshot bookkeeping, cursors release their snapshots without a key of the index
+    mutable mutex snapshot_lock;
+    //! Number of open snapshots by epoch, each snapshot takes the next epoch
+    mutable map<idx_t, idx_t> snapshots;
+    mutable idx_t snapshot_epoch = 0;
+    //! Nodes created since the last snapshot was taken, no snapshot can reach them
+    mutable unordered_set<idx_t> fresh_nodes;
+    //! Replaced nodes with the last epoch whose snapshots can reach them, oldest first
+    std::deque<pair<idx_t, IndexPointer>> retired_nodes;
+};
+
+} // namespace duckdb
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+#include "duckdb/storage/storage_index.hpp"
+
+namespace duckdb {
+
+class DuckTableEntry;
+class RTreeIndex;
+
+//-------------------------------------------------------------
+// Logical RTree Index Join
+//-------------------------------------------------------------
+//! Inner join that probes the TRTREE index of the inner table once per outer row.
+//! The single child is the outer side; its columns are followed by the fetched inner columns.
+class LogicalRTreeIndexJoin final : public LogicalExtensionOperator {
+public:
+	LogicalRTreeIndexJoin(DuckTableEntry &table, RTreeIndex &index, vector<ColumnIndex> column_ids,
+	                      vector<ColumnBinding> inner_bindings, vector<LogicalType> inner_types,
+	                      unique_ptr<Expression> probe);
+
+	DuckTableEntry &table;
+	RTreeIndex &index;
+	//! The table columns of the replaced inner scan
+	vector<ColumnIndex> column_ids;
+	vector<ColumnBinding> inner_bindings;
+	vector<LogicalType> inner_types;
+
+public:
+	string GetExtensionName() const override {
+		return "mobilityduck_rtree_index_join";
+	}
+	string GetName() const override {
+		return "RTREE_INDEX_JOIN";
+	}
+	vector<ColumnBinding> GetColumnBindings() override;
+	PhysicalOperator &CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) override;
+
+protected:
+	void ResolveTypes() override;
+};
+
+//-------------------------------------------------------------
+// Physical RTree Index Join
+//-------------------------------------------------------------
+class PhysicalRTreeIndexJoin final : public PhysicalOperator {
+public:
+	static constexpr const PhysicalOperatorType TYPE = PhysicalOperatorType::EXTENSION;
+
+public:
+	PhysicalRTreeIndexJoin(const vector<LogicalType> &types_p, DuckTableEntry &table, RTreeIndex &index,
+	                       vector<StorageIndex> storage_ids, vector<LogicalType> fetch_types,
+	                       unique_ptr<Expression> probe, idx_t estimated_cardinality);
+
+	DuckTableEntry &table;
+	RTreeIndex &index;
+	//! The inner columns to fetch, followed by the row id used to line the fetch up with the probes
+	vector<StorageIndex> storage_ids;
+	vector<LogicalType> fetch_types;
+	//! The STBOX each outer row probes the index with
+	unique_ptr<Expression> probe;
+
+public:
+	string GetName() const override {
+		return "RTREE_INDEX_JOIN";
+	}
+	InsertionOrderPreservingMap<string> ParamsToString() const override;
+
+	unique_ptr<OperatorState> GetOperatorState(ExecutionContext &context) const override;
+	OperatorResultType Execute(ExecutionContext &context, DataChunk &input, DataChunk &chunk,
+	                           GlobalOperatorState &gstate, OperatorState &state) const override;
+
+	bool ParallelOperator() const override {
+		return true;
+	}
+};
+
+} // namespace duckdb
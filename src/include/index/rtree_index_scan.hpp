@@ -2,6 +2,7 @@
 
 #include "duckdb/function/table_function.hpp"
 #include "duckdb/function/table/table_scan.hpp"
+#include "index/rtree.hpp"
 
 namespace duckdb {
 
@@ -11,14 +12,66 @@ struct RTreeIndexScanBindData : public TableFunctionData {
     DuckTableEntry &table;
     RTreeIndex &index;
     idx_t limit;
-    unique_ptr<STBox> query_stbox; 
+    //! The box the tree is searched with
+    unique_ptr<RTreeBounds> query;
+    //! Emit the limit rows nearest to the query box instead of the rows matching it
+    bool nearest = false;
+    //! How the indexed boxes relate to the query box
+    RTreePredicate predicate = RTreePredicate::OVERLAPS;
+    //! Position among the scanned columns of the column whose table filter the index answers
+    idx_t filter_column = 0;
+    //! Whether the box test decides that filter on its own. Otherwise it is rechecked on the fetched rows
+    //! like the table filters on the other columns.
+    bool exact = false;
+    //! Whether the filtered column is fetched. It is not when the box test is exact and nothing above the scan
+    //! reads the column; a scan that fetches no table column at all only checks the visibility of its rows.
+    bool read_filter_column = true;
+    //! Rows the scan is expected to produce
+    idx_t estimated_cardinality = 0;
+    //! Estimated fraction of the table the box test selects, and the fraction above which
+    //! a sequential scan would have been kept instead
+    double selectivity = 0;
+    double max_selectivity = 0;
+    //! Threads pulling row ids from the shared cursor, a nearest neighbour scan runs on one
+    idx_t max_threads = 1;
     
     RTreeIndexScanBindData(DuckTableEntry &table, RTreeIndex &index, idx_t limit, 
-                           unique_ptr<STBox> query_stbox)
-        : table(table), index(index), limit(limit), query_stbox(std::move(query_stbox)) {}
+                           unique_ptr<RTreeBounds> query)
+        : table(table), index(index), limit(limit), query(std::move(query)) {}
+};
+
+//! Bind data of a sequential scan kept because its filter selects too much of the table for the index,
+//! so that EXPLAIN shows the estimate that decided it
+struct RTreeKeptScanBindData : public TableScanBindData {
+    //! The index that could have answered the filter
+    string index_name;
+    //! Estimated fraction of the table the box test selects, and the fraction up to which the index is used
+    double selectivity;
+    double max_selectivity;
+    //! How the sequential scan itself is shown
+    table_function_to_string_t scan_to_string;
+
+    RTreeKeptScanBindData(const TableScanBindData &scan, string index_name, double selectivity,
+                          double max_selectivity, table_function_to_string_t scan_to_string)
+        : TableScanBindData(scan.table), index_name(std::move(index_name)), selectivity(selectivity),
+          max_selectivity(max_selectivity), scan_to_string(scan_to_string) {
+        is_index_scan = scan.is_index_scan;
+        is_create_index = scan.is_create_index;
+    }
+
+    unique_ptr<FunctionData> Copy() const override {
+        return make_uniq<RTreeKeptScanBindData>(*this, index_name, selectivity, max_selectivity, scan_to_string);
+    }
+
+    static InsertionOrderPreservingMap<string> ToString(TableFunctionToStringInput &input);
 };
 
 struct RTreeIndexScanFunction {
+	static constexpr const char *NAME = "mobility rtree index";
+	//! Setting with the estimated fraction of rows above which a filter is answered by a sequential scan
+	static constexpr const char *MAX_SELECTIVITY_SETTING = "trtree_index_scan_max_selectivity";
+	static constexpr double DEFAULT_MAX_SELECTIVITY = 0.1;
+
 	static TableFunction GetFunction();
 };
 
@@ -5,6 +5,8 @@
 #include "duckdb/execution/index/fixed_size_allocator.hpp"
 #include "duckdb/common/case_insensitive_map.hpp"
 #include "duckdb/optimizer/matcher/expression_matcher.hpp"
+#include "duckdb/storage/storage_lock.hpp"
+#include "index/rtree.hpp"
 
 extern "C" {
     #include <meos.h>
@@ -12,9 +14,90 @@ extern "C" {
 
 namespace duckdb {
 
+class LogicalGet;
+
+//! A filter that an index scan can answer
+struct RTreeIndexPredicate {
+    RTreePredicate predicate;
+    //! The query operand
+    optional_ptr<const Expression> query;
+    //! Whether the box test decides the filter on its own; otherwise the scan rechecks it
+    bool exact;
+    //! Whether a value can only pass the filter if the box of one of its fragments passes the box test,
+    //! which an index over split values needs to answer it
+    bool fragment_safe;
+};
+
+//! How the values of an index created WITH (split = ...) are cut into several boxes
+struct RTreeSplit {
+    enum class Type : uint8_t {
+        //! One box per value
+        NONE,
+        //! 'segments:N', at most N boxes of consecutive segments per value
+        SEGMENTS,
+        //! 'time:<interval>', one box per time bin of the given width
+        TIME
+    };
+
+    Type type = Type::NONE;
+    int32_t segments = 0;
+    interval_t duration;
+
+    bool IsEnabled() const {
+        return type != Type::NONE;
+    }
+    //! Read the split option, throws an InvalidInputException if it is malformed
+    static RTreeSplit Parse(const case_insensitive_map_t<Value> &options);
+};
+
+//! The spatial reference system and dimensions of the indexed boxes. The reference system is fixed by
+//! WITH (srid = ...) or by the first box with spatial dimensions, and kept in the index options.
+struct RTreeSpace {
+    //! Whether the reference system is known
+    bool has_x = false;
+    int32_t srid = 0;
+    bool geodetic = false;
+    //! Whether any indexed box has these dimensions
+    bool has_z = false;
+    bool has_t = false;
+
+    //! Record the box, throws an InvalidInputException if its reference system differs
+    void Add(const STBox &box);
+    //! Record the time dimension of a TBOX, whose value axis has no reference system
+    void Add(const TBox &box);
+    //! Record the boxes of the other space, throws an InvalidInputException if its reference system differs
+    void Merge(const RTreeSpace &other);
+    //! Whether the MEOS box operators can compare the query with the indexed boxes without an SRID error
+    bool IsCompatible(const STBox &query) const;
+    //! The dimensions, e.g. "XYZT"
+    string GetDimensions() const;
+
+    static RTreeSpace Parse(const case_insensitive_map_t<Value> &options);
+    void Serialize(case_insensitive_map_t<Value> &options) const;
+
+private:
+    void AddReference(int32_t box_srid, bool box_geodetic);
+};
+
+//! Leaves packed by one CREATE INDEX construction task
+struct RTreePartition {
+    unique_ptr<TRTree> tree;
+    vector<RTreeEntry> leaves;
+    //! Number of leaf entries packed
+    idx_t entry_count = 0;
+};
+
 class RTreeIndex : public BoundIndex {
 public:
     static constexpr const char *TYPE_NAME = "TRTREE";
+    //! Fraction of unused entry slots above which Vacuum repacks the tree
+    static constexpr double VACUUM_EMPTY_SLOTS = 0.5;
+    //! Number of buffered entries at which appends are merged into the tree
+    static constexpr idx_t DELTA_CAPACITY = 32 * RTreeNode::CAPACITY;
+    //! Number of nodes read to estimate the cardinality of a query
+    static constexpr idx_t ESTIMATE_NODE_BUDGET = 64;
+    //! Storage option keeping the number of leaf entries, so that it is known without walking the tree
+    static constexpr const char *ENTRY_COUNT_OPTION = "trtree_entry_count";
 
     RTreeIndex(const string &name, IndexConstraintType constraint_type,
                const vector<column_t> &column_ids, TableIOManager &table_io_manager,
@@ -35,9 +118,69 @@ public:
 
     ErrorData Insert(IndexLock &lock, DataChunk &data, Vector &row_ids) override;
 
-    ErrorData BulkConstruct(STBox* boxes, const row_t* row_ids, idx_t count) ;
-
-    void Delete(IndexLock &lock, DataChunk &entries, Vector &row_identifiers) override;
+    //! Pack one scan partition of CREATE INDEX into the leaves of a private tree.
+    //! Safe to call from several construction tasks at once.
+    unique_ptr<RTreePartition> PackPartition(vector<RTreeEntry> &entries) const;
+
+    //! Adopt the leaves of all partitions and pack the upper levels on top of them
+    ErrorData MergePartitions(vector<unique_ptr<RTreePartition>> &partitions);
+
+    //! Convert a vector of STBOX or TBOX blobs, or of temporal values through their box,
+    //! into leaf entries, skipping NULL and malformed values. Split values yield an entry per fragment.
+    //! The boxes are recorded in the space.
+    void GetEntries(Vector &box_vector, Vector &row_identifiers, idx_t count, vector<RTreeEntry> &result,
+                    RTreeSpace &space) const;
+
+    //! A copy of the space, which appends can extend concurrently
+    RTreeSpace GetSpace() const {
+        lock_guard<mutex> guard(buffer_lock);
+        return space;
+    }
+    //! Record the boxes gathered while building the index
+    void MergeSpace(const RTreeSpace &other) {
+        lock_guard<mutex> guard(buffer_lock);
+        space.Merge(other);
+    }
+
+    //! Structure of the tree, without the buffered appends. Only the counting walk and the copy of the
+    //! sampled nodes hold the shared key, the sample is measured after it is released.
+    RTreeStats GetStats() const {
+        vector<RTreeNode> sample;
+        RTreeStats stats;
+        {
+            auto tree_lock = rwlock.GetSharedLock();
+            stats = tree->GetStats(sample);
+        }
+        TRTree::MeasureSample(sample, stats);
+        return stats;
+    }
+    //! Number of appended entries not yet merged into the tree
+    idx_t GetBufferedCount(IndexLock &lock) const {
+        lock_guard<mutex> guard(buffer_lock);
+        return delta.size();
+    }
+    //! Number of leaf entries of the tree and of the append buffer, read without taking any latch
+    idx_t GetEntryCount() const {
+        return index_size;
+    }
+
+    //! Whether a row can have several leaf entries, so that scans have to deduplicate row ids
+    bool IsMultiEntry() const {
+        return split.IsEnabled();
+    }
+
+    //! Whether the index stores the boxes of values of this type rather than the values themselves
+    static bool IsTemporalType(const LogicalType &type);
+    //! Whether keys of this type are indexed through a TBOX: TBOX, TINT and TFLOAT
+    static bool IsNumberType(const LogicalType &type);
+    //! The box type the tree stores for keys of this type, TBOX or STBOX
+    static LogicalType GetBoxType(const LogicalType &key_type);
+    //! Whether the operand evaluates to the box the tree stores for a row
+    static bool IsIndexedBox(const Expression &operand, const Expression &index_expr);
+    //! Whether the operand is the temporal value whose box the tree stores for a row
+    static bool IsIndexedValue(const Expression &operand, const Expression &index_expr);
+
+    void Delete(IndexLock &lock, DataChunk &input, Vector &row_identifiers) override;
 
     ErrorData Append(IndexLock &lock, DataChunk &entries, Vector &row_identifiers) override;
 
@@ -46,6 +189,9 @@ public:
     //! Commit a drop operation
     void CommitDrop(IndexLock &index_lock) override;
 
+    //! Serialize the node buffers to the index block manager (checkpoint) or into the info (WAL)
+    IndexStorageInfo GetStorageInfo(const case_insensitive_map_t<Value> &options, const bool to_wal) override;
+
     bool MergeIndexes(IndexLock &state, BoundIndex &other_index) override;
 
     void Vacuum(IndexLock &lock) override;
@@ -59,28 +205,93 @@ public:
     string GetConstraintViolationMessage(VerifyExistenceType verify_type, idx_t failed_index,
                                        DataChunk &input) override;
 
-    unique_ptr<IndexScanState> InitializeScan(const void* query_blob, size_t blob_size) const;
+    //! Convert a constant query operand into the box the tree is searched with. Fails for a NULL or malformed
+    //! value, a box of the other kind than the indexed one, and an STBOX the reference system of the index
+    //! cannot be compared with.
+    bool TryGetQueryBounds(const Value &query, RTreeBounds &result) const;
+
+    unique_ptr<IndexScanState> InitializeScan(const RTreeBounds &query,
+                                              RTreePredicate predicate = RTreePredicate::OVERLAPS) const;
 
     vector<row_t> SearchStbox(const STBox *query_stbox) const;
 
+    //! Search all query boxes in one traversal of the tree, which visits every node once with the queries
+    //! that intersect it
+    unique_ptr<IndexScanState> InitializeBatchScan(vector<RTreeBounds> queries) const;
+    //! Emit up to a vector of (query index, row id) pairs whose boxes intersect into the UINTEGER and ROW_TYPE
+    //! columns of the result. Returns the number of pairs, 0 once the batch is exhausted.
+    idx_t BatchScan(IndexScanState &state, DataChunk &result) const;
+
+    //! Estimate the number of rows whose boxes intersect the query from the upper levels of the tree
+    idx_t EstimateCardinality(const RTreeBounds &query) const;
+
+    //! Append the row ids of all boxes intersecting the query, each row id once
+    void Search(const RTreeBounds &query, vector<row_t> &result) const;
+
 
     idx_t Scan(IndexScanState &state, Vector &result) const;
+    //! Emit up to capacity row ids of the scan into the buffer, returns the number written
+    idx_t Scan(IndexScanState &state, row_t *row_ids, idx_t capacity) const;
+
+    //! Scan the row ids of the boxes in increasing distance to the query, for as long as the caller reads
+    unique_ptr<IndexScanState> InitializeNearestScan(const RTreeBounds &query) const;
 
     bool TryMatchDistanceFunction(const unique_ptr<Expression> &expr, vector<reference<Expression>> &bindings) const;
 
+    //! Match a `<->` / nearestApproachDistance call between two STBOX operands
+    bool TryMatchNearestFunction(const unique_ptr<Expression> &expr, vector<reference<Expression>> &bindings) const;
+
+    //! Rewrite the indexed expression in terms of the column bindings of the get, fails if the get
+    //! does not scan every column the expression needs
+    bool TryBindIndexExpression(LogicalGet &get, unique_ptr<Expression> &result) const;
+
+    //! Match a box predicate `&&`, `@>` or `<@` between the bound index expression, or a temporal value
+    //! whose box is indexed, and a query that must be constant unless told otherwise: an STBOX or TSTZSPAN
+    //! for an STBOX index, a TBOX for a TBOX index.
+    //! `atStbox(value, query) IS NOT NULL` matches as a lossy overlap.
+    static bool TryMatchPredicate(const Expression &expr, const Expression &index_expr,
+                                  RTreeIndexPredicate &result, bool constant_query = true);
+
 
 
 private:
     case_insensitive_map_t<Value> options_;
-    
+    RTreeSplit split;
+    RTreeSpace space;
+
     unique_ptr<ExpressionMatcher> function_matcher;
     unique_ptr<ExpressionMatcher> MakeFunctionMatcher() const;
-
-    RTree *rtree_;
-    STBox *boxes;
-    size_t current_size_ = 0;
-    size_t current_capacity_ = 0;
-    StorageLock rwlock;
+    unique_ptr<ExpressionMatcher> nearest_matcher;
+    unique_ptr<ExpressionMatcher> MakeNearestMatcher() const;
+
+    // Concurrency. Scans of several connections run next to appends, deletes and checkpoints:
+    // - rwlock latches the tree. A scan holds a shared key during each call that initializes or advances its
+    //   cursor, never between calls, so an open cursor that is not read does not hold back writers. Merging the
+    //   append buffer, deleting from the tree, repacking, dropping and checkpointing hold it exclusively. A
+    //   waiting writer keeps new shared keys out, it waits for at most one call of each open scan.
+    // - A cursor holds a snapshot of the tree from the call that positions it until it is exhausted or
+    //   destroyed. Writers do not change or free the nodes a snapshot can reach: they copy a node before
+    //   changing it, link the copy in its place and retire the original. Retired nodes are freed by the next
+    //   writer once every snapshot that can reach them is released, so cursors resume where they stopped.
+    // - buffer_lock guards the append buffer and the space, which appends change without touching the tree.
+    //   A scan copies its buffered matches under its shared key, so that no merge can move an entry from the
+    //   buffer into the tree in between.
+    // - index_size counts the leaf entries of the tree and the buffer.
+    // Appends never wait for scans: a full buffer is merged only if the tree can be latched right away,
+    // otherwise it keeps growing until an append, a vacuum or a checkpoint finds the tree free. Latches are
+    // taken in the order rwlock, then buffer_lock.
+    unique_ptr<TRTree> tree;
+    //! Entries appended since the last flush, matched linearly next to the tree
+    vector<RTreeEntry> delta;
+    //! Bulk load the buffered entries and merge them into the tree, the caller holds the tree exclusively
+    void FlushDelta();
+    //! Latch the tree exclusively once the calls of the scans reading it have returned
+    unique_ptr<StorageLockKey> LockTreeExclusive();
+    //! Position the cursor of a scan at the start of the tree and copy its buffered matches, under a shared key
+    void StartScan(IndexScanState &state) const;
+    void StartBatchScan(IndexScanState &state) const;
+    mutable mutex buffer_lock;
+    mutable StorageLock rwlock;
     atomic<idx_t> index_size = {0};
 
 };
@@ -89,6 +300,8 @@ struct RTreeModule {
 	static void RegisterRTreeIndex(DatabaseInstance &instance);
     static void RegisterIndexScan(DatabaseInstance &instance);
     static void RegisterScanOptimizer(DatabaseInstance &instance);
+    static void RegisterIndexJoinOptimizer(DatabaseInstance &instance);
+    static void RegisterIndexPragmas(DatabaseInstance &instance);
 };
 
 } // namespace duckdb
\ No newline at end of file
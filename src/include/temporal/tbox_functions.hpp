@@ -118,6 +118,15 @@ struct TboxFunctions {
     static void Tbox_expand_value(DataChunk &args, ExpressionState &state, Vector &result);
 
     static void Tbox_expand_time(DataChunk &args, ExpressionState &state, Vector &result);
+
+    /* ***************************************************
+     * Topological operators
+     ****************************************************/
+    static void TboxTopoExecutor(Vector &tbox1, Vector &tbox2, bool (*op)(const TBox *, const TBox *),
+                                 Vector &result, idx_t count);
+    static void Overlaps_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contains_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contained_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result);
 };
 
 } // namespace duckdb
\ No newline at end of file
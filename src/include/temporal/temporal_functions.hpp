@@ -41,6 +41,9 @@ struct TemporalFunctions {
      ****************************************************/
     static void Temporal_to_tstzspan(DataChunk &args, ExpressionState &state, Vector &result);
     static void Tnumber_to_span(DataChunk &args, ExpressionState &state, Vector &result);
+    static void TnumberToTboxExecutor(Vector &source, Vector &result, idx_t count);
+    static void Tnumber_to_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static bool Tnumber_to_tbox_cast(Vector &source, Vector &result, idx_t count, CastParameters &parameters);
 
     /* ***************************************************
      * Accessor functions
@@ -82,6 +85,16 @@ struct TemporalFunctions {
      * Boolean operators
      ****************************************************/
     static void Tbool_when_true(DataChunk &args, ExpressionState &state, Vector &result);
+
+    /* ***************************************************
+     * Topological operators
+     ****************************************************/
+    static void Overlaps_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contains_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contained_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Overlaps_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contains_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result);
+    static void Contained_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result);
 };
 
 } // namespace duckdb
\ No newline at end of file
@@ -0,0 +1,1436 @@
+#include "meos_wrapper_simple.hpp"
+
+#include "duckdb/common/bit_utils.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "index/rtree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace duckdb {
+
+//------------------------------------------------------------------------------
+// RTreeBounds
+//------------------------------------------------------------------------------
+static constexpr double RTREE_INF = std::numeric_limits<double>::infinity();
+
+RTreeBounds RTreeBounds::Empty() {
+    RTreeBounds result;
+    result.xmin = result.ymin = result.zmin = RTREE_INF;
+    result.xmax = result.ymax = result.zmax = -RTREE_INF;
+    result.tmin = NumericLimits<int64_t>::Maximum();
+    result.tmax = NumericLimits<int64_t>::Minimum();
+    return result;
+}
+
+RTreeBounds RTreeBounds::Unbounded() {
+    RTreeBounds result;
+    result.xmin = result.ymin = result.zmin = -RTREE_INF;
+    result.xmax = result.ymax = result.zmax = RTREE_INF;
+    result.tmin = NumericLimits<int64_t>::Minimum();
+    result.tmax = NumericLimits<int64_t>::Maximum();
+    return result;
+}
+
+RTreeBounds RTreeBounds::FromSTBox(const STBox &box) {
+    auto result = Unbounded();
+    if (MEOS_FLAGS_GET_X(box.flags)) {
+        result.xmin = box.xmin;
+        result.xmax = box.xmax;
+        result.ymin = box.ymin;
+        result.ymax = box.ymax;
+        if (MEOS_FLAGS_GET_Z(box.flags)) {
+            result.zmin = box.zmin;
+            result.zmax = box.zmax;
+        }
+    }
+    if (MEOS_FLAGS_GET_T(box.flags)) {
+        auto lower = static_cast<int64_t>(box.period.lower);
+        auto upper = static_cast<int64_t>(box.period.upper);
+        result.tmin = box.period.lower_inc ? lower : lower + 1;
+        result.tmax = box.period.upper_inc ? upper : upper - 1;
+    }
+    return result;
+}
+
+RTreeBounds RTreeBounds::FromTBox(const TBox &box) {
+    auto result = Unbounded();
+    if (MEOS_FLAGS_GET_X(box.flags)) {
+        tbox_xmin(&box, &result.xmin);
+        tbox_xmax(&box, &result.xmax);
+    }
+    if (MEOS_FLAGS_GET_T(box.flags)) {
+        auto lower = static_cast<int64_t>(box.period.lower);
+        auto upper = static_cast<int64_t>(box.period.upper);
+        result.tmin = box.period.lower_inc ? lower : lower + 1;
+        result.tmax = box.period.upper_inc ? upper : upper - 1;
+    }
+    return result;
+}
+
+bool RTreeBounds::FromBlob(const string_t &blob, RTreeBounds &result) {
+    if (blob.GetSize() < sizeof(STBox)) {
+        return false;
+    }
+    // The blob data is not guaranteed to be aligned
+    STBox box;
+    memcpy(&box, blob.GetData(), sizeof(STBox));
+    result = FromSTBox(box);
+    return true;
+}
+
+bool RTreeBounds::Intersects(const RTreeBounds &other) const {
+    return xmin <= other.xmax && other.xmin <= xmax && ymin <= other.ymax && other.ymin <= ymax &&
+           zmin <= other.zmax && other.zmin <= zmax && tmin <= other.tmax && other.tmin <= tmax;
+}
+
+bool RTreeBounds::Contains(const RTreeBounds &other) const {
+    return xmin <= other.xmin && other.xmax <= xmax && ymin <= other.ymin && other.ymax <= ymax &&
+           zmin <= other.zmin && other.zmax <= zmax && tmin <= other.tmin && other.tmax <= tmax;
+}
+
+void RTreeBounds::Union(const RTreeBounds &other) {
+    xmin = MinValue(xmin, other.xmin);
+    ymin = MinValue(ymin, other.ymin);
+    zmin = MinValue(zmin, other.zmin);
+    tmin = MinValue(tmin, other.tmin);
+    xmax = MaxValue(xmax, other.xmax);
+    ymax = MaxValue(ymax, other.ymax);
+    zmax = MaxValue(zmax, other.zmax);
+    tmax = MaxValue(tmax, other.tmax);
+}
+
+bool RTreeBounds::HasAxis(idx_t axis) const {
+    switch (axis) {
+    case AXIS_X:
+        return std::isfinite(xmin) && std::isfinite(xmax);
+    case AXIS_Y:
+        return std::isfinite(ymin) && std::isfinite(ymax);
+    case AXIS_Z:
+        return std::isfinite(zmin) && std::isfinite(zmax);
+    default:
+        return tmin != NumericLimits<int64_t>::Minimum() && tmax != NumericLimits<int64_t>::Maximum();
+    }
+}
+
+double RTreeBounds::Center(idx_t axis) const {
+    if (!HasAxis(axis)) {
+        return 0;
+    }
+    switch (axis) {
+    case AXIS_X:
+        return xmin / 2 + xmax / 2;
+    case AXIS_Y:
+        return ymin / 2 + ymax / 2;
+    case AXIS_Z:
+        return zmin / 2 + zmax / 2;
+    default:
+        return static_cast<double>(tmin) / 2 + static_cast<double>(tmax) / 2;
+    }
+}
+
+static double AxisExtent(const RTreeBounds &bounds, idx_t axis) {
+    if (!bounds.HasAxis(axis)) {
+        return 0;
+    }
+    switch (axis) {
+    case RTreeBounds::AXIS_X:
+        return bounds.xmax - bounds.xmin;
+    case RTreeBounds::AXIS_Y:
+        return bounds.ymax - bounds.ymin;
+    case RTreeBounds::AXIS_Z:
+        return bounds.zmax - bounds.zmin;
+    default:
+        return static_cast<double>(bounds.tmax) - static_cast<double>(bounds.tmin);
+    }
+}
+
+//! Bounds along an axis, infinite where the box does not have the axis
+static double AxisMin(const RTreeBounds &bounds, idx_t axis) {
+    switch (axis) {
+    case RTreeBounds::AXIS_X:
+        return bounds.xmin;
+    case RTreeBounds::AXIS_Y:
+        return bounds.ymin;
+    case RTreeBounds::AXIS_Z:
+        return bounds.zmin;
+    default:
+        return bounds.HasAxis(axis) ? static_cast<double>(bounds.tmin) : -std::numeric_limits<double>::infinity();
+    }
+}
+
+static double AxisMax(const RTreeBounds &bounds, idx_t axis) {
+    switch (axis) {
+    case RTreeBounds::AXIS_X:
+        return bounds.xmax;
+    case RTreeBounds::AXIS_Y:
+        return bounds.ymax;
+    case RTreeBounds::AXIS_Z:
+        return bounds.zmax;
+    default:
+        return bounds.HasAxis(axis) ? static_cast<double>(bounds.tmax) : std::numeric_limits<double>::infinity();
+    }
+}
+
+double RTreeBounds::Area() const {
+    double area = 1;
+    bool any = false;
+    for (idx_t axis = 0; axis < AXIS_COUNT; axis++) {
+        if (HasAxis(axis)) {
+            area *= AxisExtent(*this, axis);
+            any = true;
+        }
+    }
+    return any ? area : 0;
+}
+
+double RTreeBounds::Margin() const {
+    double margin = 0;
+    for (idx_t axis = 0; axis < AXIS_COUNT; axis++) {
+        margin += AxisExtent(*this, axis);
+    }
+    return margin;
+}
+
+static double AxisGap(double min1, double max1, double min2, double max2) {
+    if (max1 < min2) {
+        return min2 - max1;
+    }
+    if (max2 < min1) {
+        return min1 - max2;
+    }
+    return 0;
+}
+
+double RTreeBounds::MinDistance(const RTreeBounds &other) const {
+    if (HasAxis(AXIS_T) && other.HasAxis(AXIS_T) && (tmax < other.tmin || other.tmax < tmin)) {
+        return NumericLimits<double>::Maximum();
+    }
+    // A missing spatial axis is unbounded and therefore never contributes a gap
+    const auto dx = AxisGap(xmin, xmax, other.xmin, other.xmax);
+    const auto dy = AxisGap(ymin, ymax, other.ymin, other.ymax);
+    auto distance = dx * dx + dy * dy;
+    if (HasAxis(AXIS_Z) && other.HasAxis(AXIS_Z)) {
+        const auto dz = AxisGap(zmin, zmax, other.zmin, other.zmax);
+        distance += dz * dz;
+    }
+    return std::sqrt(distance);
+}
+
+//------------------------------------------------------------------------------
+// RTreeNode
+//------------------------------------------------------------------------------
+RTreeBounds RTreeNode::GetBounds() const {
+    auto result = RTreeBounds::Empty();
+    for (idx_t i = 0; i < count; i++) {
+        result.xmin = MinValue(result.xmin, xmin[i]);
+        result.ymin = MinValue(result.ymin, ymin[i]);
+        result.zmin = MinValue(result.zmin, zmin[i]);
+        result.tmin = MinValue(result.tmin, tmin[i]);
+        result.xmax = MaxValue(result.xmax, xmax[i]);
+        result.ymax = MaxValue(result.ymax, ymax[i]);
+        result.zmax = MaxValue(result.zmax, zmax[i]);
+        result.tmax = MaxValue(result.tmax, tmax[i]);
+    }
+    return result;
+}
+
+RTreeBounds RTreeNode::GetEntryBounds(idx_t idx) const {
+    RTreeBounds result;
+    result.xmin = xmin[idx];
+    result.ymin = ymin[idx];
+    result.zmin = zmin[idx];
+    result.xmax = xmax[idx];
+    result.ymax = ymax[idx];
+    result.zmax = zmax[idx];
+    result.tmin = tmin[idx];
+    result.tmax = tmax[idx];
+    return result;
+}
+
+void RTreeNode::SetEntryBounds(idx_t idx, const RTreeBounds &bounds) {
+    xmin[idx] = bounds.xmin;
+    ymin[idx] = bounds.ymin;
+    zmin[idx] = bounds.zmin;
+    xmax[idx] = bounds.xmax;
+    ymax[idx] = bounds.ymax;
+    zmax[idx] = bounds.zmax;
+    tmin[idx] = bounds.tmin;
+    tmax[idx] = bounds.tmax;
+}
+
+vector<RTreeEntry> RTreeNode::GetEntries() const {
+    vector<RTreeEntry> result;
+    result.reserve(count);
+    for (idx_t i = 0; i < count; i++) {
+        result.push_back(GetEntry(i));
+    }
+    return result;
+}
+
+void RTreeNode::SetEntries(const RTreeEntry *entries, idx_t entry_count) {
+    D_ASSERT(entry_count <= CAPACITY);
+    for (idx_t i = 0; i < entry_count; i++) {
+        SetEntry(i, entries[i]);
+    }
+    count = NumericCast<uint32_t>(entry_count);
+}
+
+//------------------------------------------------------------------------------
+// TRTree
+//------------------------------------------------------------------------------
+TRTree::TRTree(BlockManager &block_manager) {
+    allocator = make_uniq<FixedSizeAllocator>(sizeof(RTreeNode), block_manager);
+}
+
+RTreeNode &TRTree::GetNode(const IndexPointer ptr) const {
+    return *allocator->Get<RTreeNode>(ptr);
+}
+
+const RTreeNode &TRTree::GetNodeReadOnly(const IndexPointer ptr) const {
+    // The node stays valid after the latch is released, a pinned buffer is only unloaded by a writer
+    lock_guard<mutex> guard(pin_lock);
+    return *allocator->Get<RTreeNode>(ptr, false);
+}
+
+idx_t TRTree::GetInMemorySize() const {
+    lock_guard<mutex> guard(pin_lock);
+    return allocator->GetInMemorySize();
+}
+
+IndexPointer TRTree::NewNode(uint32_t level) {
+    auto ptr = allocator->New();
+    ptr.SetMetadata(NODE_METADATA);
+    auto &node = GetNode(ptr);
+    node.level = level;
+    node.count = 0;
+    lock_guard<mutex> guard(snapshot_lock);
+    if (!snapshots.empty()) {
+        fresh_nodes.insert(ptr.Get());
+    }
+    return ptr;
+}
+
+void TRTree::Reset() {
+    {
+        lock_guard<mutex> guard(snapshot_lock);
+        if (snapshots.empty()) {
+            allocator->Reset();
+            retired_nodes.clear();
+            fresh_nodes.clear();
+            root.Clear();
+            return;
+        }
+    }
+    vector<IndexPointer> stack;
+    if (!IsEmpty()) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+        auto &node = GetNodeReadOnly(ptr);
+        if (!node.IsLeaf()) {
+            for (idx_t i = 0; i < node.count; i++) {
+                IndexPointer child;
+                child.Set(node.data[i]);
+                stack.push_back(child);
+            }
+        }
+        FreeNode(ptr);
+    }
+    root.Clear();
+}
+
+//------------------------------------------------------------------------------
+// Snapshots
+//------------------------------------------------------------------------------
+RTreeSnapshot::~RTreeSnapshot() {
+    tree.CloseSnapshot(epoch);
+}
+
+unique_ptr<RTreeSnapshot> TRTree::OpenSnapshot() const {
+    lock_guard<mutex> guard(snapshot_lock);
+    // Every node of the tree is reachable from the new snapshot
+    fresh_nodes.clear();
+    snapshots[++snapshot_epoch]++;
+    return make_uniq<RTreeSnapshot>(*this, snapshot_epoch);
+}
+
+void TRTree::CloseSnapshot(idx_t epoch) const {
+    lock_guard<mutex> guard(snapshot_lock);
+    auto entry = snapshots.find(epoch);
+    D_ASSERT(entry != snapshots.end());
+    if (--entry->second == 0) {
+        snapshots.erase(entry);
+    }
+    if (snapshots.empty()) {
+        fresh_nodes.clear();
+    }
+}
+
+void TRTree::FreeNode(IndexPointer ptr) {
+    {
+        lock_guard<mutex> guard(snapshot_lock);
+        if (!snapshots.empty() && fresh_nodes.erase(ptr.Get()) == 0) {
+            retired_nodes.emplace_back(snapshot_epoch, ptr);
+            return;
+        }
+    }
+    allocator->Free(ptr);
+}
+
+IndexPointer TRTree::CopyOnWrite(IndexPointer ptr) {
+    {
+        lock_guard<mutex> guard(snapshot_lock);
+        if (snapshots.empty() || fresh_nodes.count(ptr.Get())) {
+            return ptr;
+        }
+    }
+    auto copy = NewNode(0);
+    GetNode(copy) = GetNodeReadOnly(ptr);
+    FreeNode(ptr);
+    return copy;
+}
+
+void TRTree::ReleaseRetired() {
+    lock_guard<mutex> guard(snapshot_lock);
+    // A node retired in an epoch is reachable from the snapshots of that epoch and the ones before
+    const auto oldest = snapshots.empty() ? NumericLimits<idx_t>::Maximum() : snapshots.begin()->first;
+    while (!retired_nodes.empty() && retired_nodes.front().first < oldest) {
+        allocator->Free(retired_nodes.front().second);
+        retired_nodes.pop_front();
+    }
+}
+
+idx_t TRTree::GetRetiredCount() const {
+    lock_guard<mutex> guard(snapshot_lock);
+    return retired_nodes.size();
+}
+
+bool TRTree::HasOpenSnapshots() const {
+    lock_guard<mutex> guard(snapshot_lock);
+    return !snapshots.empty();
+}
+
+double TRTree::GetEmptySlots() const {
+    if (IsEmpty()) {
+        return 0;
+    }
+    // Counted without the rest of GetStats, Vacuum checks it on every checkpoint
+    idx_t node_count = 0;
+    idx_t slot_count = 0;
+    vector<IndexPointer> stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+        auto &node = GetNodeReadOnly(ptr);
+        node_count++;
+        slot_count += node.count;
+        if (node.IsLeaf()) {
+            continue;
+        }
+        for (idx_t i = 0; i < node.count; i++) {
+            IndexPointer child;
+            child.Set(node.data[i]);
+            stack.push_back(child);
+        }
+    }
+    return 1 - static_cast<double>(slot_count) / static_cast<double>(node_count * RTreeNode::CAPACITY);
+}
+
+//! Fraction of the node box that two of its entry boxes share, the product over the axes the node spans of
+//! the shared extent relative to the node extent. Returns false if the node box has no extent on any axis.
+static bool GetSharedFraction(const RTreeBounds &bounds, const RTreeBounds &a, const RTreeBounds &b,
+                              double &result) {
+    result = a.Intersects(b) ? 1 : 0;
+    bool any = false;
+    for (idx_t axis = 0; axis < RTreeBounds::AXIS_COUNT; axis++) {
+        const auto extent = AxisExtent(bounds, axis);
+        if (extent <= 0) {
+            continue;
+        }
+        any = true;
+        const auto shared =
+            MinValue(AxisMax(a, axis), AxisMax(b, axis)) - MaxValue(AxisMin(a, axis), AxisMin(b, axis));
+        result *= MaxValue(shared, 0.0) / extent;
+    }
+    return any;
+}
+
+//! Fraction of the box of the node that no entry box covers, counted on a lattice of sample points over the
+//! axes the node spans. Returns false if the node box has no extent on any axis.
+static bool GetUncoveredFraction(const RTreeNode &node, double &result) {
+    const auto bounds = node.GetBounds();
+    vector<idx_t> axes;
+    for (idx_t axis = 0; axis < RTreeBounds::AXIS_COUNT; axis++) {
+        if (AxisExtent(bounds, axis) > 0) {
+            axes.push_back(axis);
+        }
+    }
+    if (axes.empty()) {
+        return false;
+    }
+    // About 256 samples whatever the number of axes
+    const idx_t steps = axes.size() <= 2 ? 16 : (axes.size() == 3 ? 6 : 4);
+    idx_t sample_count = 1;
+    for (idx_t i = 0; i < axes.size(); i++) {
+        sample_count *= steps;
+    }
+    vector<RTreeBounds> entries;
+    entries.reserve(node.count);
+    for (idx_t i = 0; i < node.count; i++) {
+        entries.push_back(node.GetEntryBounds(i));
+    }
+
+    double point[RTreeBounds::AXIS_COUNT];
+    idx_t uncovered = 0;
+    for (idx_t sample = 0; sample < sample_count; sample++) {
+        auto step = sample;
+        for (idx_t i = 0; i < axes.size(); i++) {
+            const auto offset = static_cast<double>(step % steps) + 0.5;
+            point[i] = AxisMin(bounds, axes[i]) + offset * AxisExtent(bounds, axes[i]) / static_cast<double>(steps);
+            step /= steps;
+        }
+        bool covered = false;
+        for (auto &entry : entries) {
+            covered = true;
+            for (idx_t i = 0; i < axes.size() && covered; i++) {
+                covered = AxisMin(entry, axes[i]) <= point[i] && point[i] <= AxisMax(entry, axes[i]);
+            }
+            if (covered) {
+                break;
+            }
+        }
+        if (!covered) {
+            uncovered++;
+        }
+    }
+    result = static_cast<double>(uncovered) / static_cast<double>(sample_count);
+    return true;
+}
+
+RTreeStats TRTree::GetStats(optional_ptr<vector<RTreeNode>> sample) const {
+    RTreeStats stats;
+    if (IsEmpty()) {
+        return stats;
+    }
+    stats.level_nodes.resize(GetNodeReadOnly(root).level + 1, 0);
+    idx_t slot_count = 0;
+    // Every stride-th node is sampled, the stride doubles whenever the sample is full
+    idx_t stride = 1;
+    vector<IndexPointer> stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+        auto &node = GetNodeReadOnly(ptr);
+        if (sample && stats.node_count % stride == 0) {
+            if (sample->size() == STATS_SAMPLE_NODES) {
+                for (idx_t i = 0; i * 2 < sample->size(); i++) {
+                    (*sample)[i] = (*sample)[i * 2];
+                }
+                sample->resize(STATS_SAMPLE_NODES / 2);
+                stride *= 2;
+            }
+            if (stats.node_count % stride == 0) {
+                sample->push_back(node);
+            }
+        }
+        stats.level_nodes[node.level]++;
+        stats.node_count++;
+        slot_count += node.count;
+        if (node.IsLeaf()) {
+            stats.entry_count += node.count;
+            continue;
+        }
+        for (idx_t i = 0; i < node.count; i++) {
+            IndexPointer child;
+            child.Set(node.data[i]);
+            stack.push_back(child);
+        }
+    }
+    stats.fill = static_cast<double>(slot_count) / static_cast<double>(stats.node_count * RTreeNode::CAPACITY);
+    return stats;
+}
+
+void TRTree::MeasureSample(const vector<RTreeNode> &sample, RTreeStats &stats) {
+    double uncovered_sum = 0;
+    idx_t uncovered_nodes = 0;
+    double shared_sum = 0;
+    idx_t shared_nodes = 0;
+    for (auto &node : sample) {
+        double uncovered;
+        if (GetUncoveredFraction(node, uncovered)) {
+            uncovered_sum += uncovered;
+            uncovered_nodes++;
+        }
+        if (node.level != 1) {
+            continue;
+        }
+        // The entries of this node are the bounds of sibling leaves
+        const auto bounds = node.GetBounds();
+        double node_shared = 0;
+        bool measured = false;
+        for (idx_t i = 0; i < node.count; i++) {
+            for (idx_t j = i + 1; j < node.count; j++) {
+                double shared;
+                measured = GetSharedFraction(bounds, node.GetEntryBounds(i), node.GetEntryBounds(j), shared);
+                node_shared += shared;
+            }
+        }
+        if (measured) {
+            shared_sum += node_shared;
+            shared_nodes++;
+        }
+    }
+    if (uncovered_nodes > 0) {
+        stats.dead_space = uncovered_sum / static_cast<double>(uncovered_nodes);
+    }
+    if (shared_nodes > 0) {
+        stats.leaf_overlap = shared_sum / static_cast<double>(shared_nodes);
+    }
+}
+
+void TRTree::Repack() {
+    vector<RTreeEntry> leaves;
+    vector<IndexPointer> stack;
+    if (!IsEmpty()) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+        auto &node = GetNodeReadOnly(ptr);
+        if (node.IsLeaf()) {
+            auto entries = node.GetEntries();
+            leaves.insert(leaves.end(), entries.begin(), entries.end());
+            continue;
+        }
+        for (idx_t i = 0; i < node.count; i++) {
+            IndexPointer child;
+            child.Set(node.data[i]);
+            stack.push_back(child);
+        }
+    }
+    Reset();
+    BulkLoad(leaves);
+}
+
+//------------------------------------------------------------------------------
+// Sort-Tile-Recursive packing
+//------------------------------------------------------------------------------
+vector<idx_t> TRTree::GetActiveAxes(const RTreeEntry *begin, const RTreeEntry *end) {
+    vector<idx_t> axes;
+    for (idx_t axis = 0; axis < RTreeBounds::AXIS_COUNT; axis++) {
+        for (auto entry = begin; entry != end; entry++) {
+            if (entry->bounds.HasAxis(axis)) {
+                axes.push_back(axis);
+                break;
+            }
+        }
+    }
+    if (axes.empty()) {
+        axes.push_back(RTreeBounds::AXIS_X);
+    }
+    return axes;
+}
+
+static void SortByAxis(RTreeEntry *begin, RTreeEntry *end, idx_t axis) {
+    std::sort(begin, end, [axis](const RTreeEntry &a, const RTreeEntry &b) {
+        return a.bounds.Center(axis) < b.bounds.Center(axis);
+    });
+}
+
+static void SortTileRecursiveInternal(RTreeEntry *begin, RTreeEntry *end, const vector<idx_t> &axes,
+                                      idx_t axis_idx) {
+    SortByAxis(begin, end, axes[axis_idx]);
+    if (axis_idx + 1 == axes.size()) {
+        return;
+    }
+    // Cut the run into slabs of whole nodes along the current axis, then tile each slab on the remaining axes
+    const auto count = NumericCast<idx_t>(end - begin);
+    const auto node_count = (count + RTreeNode::CAPACITY - 1) / RTreeNode::CAPACITY;
+    const auto remaining_axes = static_cast<double>(axes.size() - axis_idx);
+    const auto slab_count =
+        MaxValue<idx_t>(1, static_cast<idx_t>(std::ceil(std::pow(static_cast<double>(node_count), 1 / remaining_axes))));
+    const auto slab_size = ((node_count + slab_count - 1) / slab_count) * RTreeNode::CAPACITY;
+
+    for (idx_t offset = 0; offset < count; offset += slab_size) {
+        auto slab_end = MinValue(count, offset + slab_size);
+        SortTileRecursiveInternal(begin + offset, begin + slab_end, axes, axis_idx + 1);
+    }
+}
+
+void TRTree::SortTileRecursive(vector<RTreeEntry> &entries) {
+    if (entries.size() <= RTreeNode::CAPACITY) {
+        return;
+    }
+    auto begin = entries.data();
+    auto end = begin + entries.size();
+    SortTileRecursiveInternal(begin, end, GetActiveAxes(begin, end), 0);
+}
+
+vector<RTreeEntry> TRTree::PackLevel(vector<RTreeEntry> &entries, uint32_t level) {
+    SortTileRecursive(entries);
+
+    vector<RTreeEntry> parents;
+    parents.reserve((entries.size() + RTreeNode::CAPACITY - 1) / RTreeNode::CAPACITY);
+    for (idx_t offset = 0; offset < entries.size(); offset += RTreeNode::CAPACITY) {
+        auto count = MinValue<idx_t>(RTreeNode::CAPACITY, entries.size() - offset);
+        auto ptr = NewNode(level);
+        auto &node = GetNode(ptr);
+        node.SetEntries(entries.data() + offset, count);
+        parents.emplace_back(node.GetBounds(), ptr.Get());
+    }
+    return parents;
+}
+
+void TRTree::BulkLoad(vector<RTreeEntry> &entries, uint32_t level) {
+    D_ASSERT(IsEmpty());
+    if (entries.empty()) {
+        return;
+    }
+    if (level > 0 && entries.size() == 1) {
+        // A single node of the level below is already the root
+        root.Set(entries[0].data);
+        entries.clear();
+        return;
+    }
+
+    while (true) {
+        auto parents = PackLevel(entries, level);
+        if (parents.size() == 1) {
+            root.Set(parents[0].data);
+            break;
+        }
+        entries = std::move(parents);
+        level++;
+    }
+    entries.clear();
+}
+
+//------------------------------------------------------------------------------
+// Merge
+//------------------------------------------------------------------------------
+static IndexPointer RebasePointer(const idx_t data, const idx_t buffer_offset) {
+    IndexPointer ptr;
+    ptr.Set(data);
+    IndexPointer result(NumericCast<uint32_t>(ptr.GetBufferId() + buffer_offset),
+                        NumericCast<uint32_t>(ptr.GetOffset()));
+    result.SetMetadata(TRTree::NODE_METADATA);
+    return result;
+}
+
+void TRTree::RebaseNodes(IndexPointer node_ptr, idx_t buffer_offset) {
+    auto &node = GetNode(node_ptr);
+    if (node.IsLeaf()) {
+        return;
+    }
+    for (idx_t i = 0; i < node.count; i++) {
+        IndexPointer child;
+        child.Set(node.data[i]);
+        RebaseNodes(child, buffer_offset);
+        node.data[i] = RebasePointer(node.data[i], buffer_offset).Get();
+    }
+}
+
+void TRTree::MergeNodes(TRTree &other, vector<RTreeEntry> &entries) {
+    // Buffers of the other allocator are appended after our highest buffer id
+    const auto buffer_offset = allocator->GetUpperBoundBufferId();
+    if (buffer_offset != 0) {
+        for (auto &entry : entries) {
+            IndexPointer ptr;
+            ptr.Set(entry.data);
+            other.RebaseNodes(ptr, buffer_offset);
+            entry.data = RebasePointer(entry.data, buffer_offset).Get();
+        }
+    }
+    allocator->Merge(*other.allocator);
+    other.root.Clear();
+}
+
+void TRTree::DissolveBranches(IndexPointer node_ptr, vector<RTreeEntry> &leaf_nodes) {
+    auto &node = GetNode(node_ptr);
+    if (node.IsLeaf()) {
+        leaf_nodes.emplace_back(node.GetBounds(), node_ptr.Get());
+        return;
+    }
+    for (idx_t i = 0; i < node.count; i++) {
+        IndexPointer child;
+        child.Set(node.data[i]);
+        DissolveBranches(child, leaf_nodes);
+    }
+    FreeNode(node_ptr);
+}
+
+void TRTree::Merge(TRTree &other) {
+    if (other.IsEmpty()) {
+        return;
+    }
+    // Only the pointer of the entry matters, it is rebased into this allocator
+    vector<RTreeEntry> other_root;
+    other_root.emplace_back(RTreeBounds::Unbounded(), other.root.Get());
+    MergeNodes(other, other_root);
+    IndexPointer lower;
+    lower.Set(other_root[0].data);
+    if (IsEmpty()) {
+        root = lower;
+        return;
+    }
+
+    if (GetNode(lower).level > GetNode(root).level) {
+        std::swap(root, lower);
+    }
+    vector<RTreeEntry> leaf_nodes;
+    DissolveBranches(lower, leaf_nodes);
+
+    if (GetNode(root).IsLeaf()) {
+        // Two single leaves, put a root on top of them
+        leaf_nodes.emplace_back(GetNode(root).GetBounds(), root.Get());
+        root.Clear();
+        BulkLoad(leaf_nodes, 1);
+        return;
+    }
+    for (auto &leaf_node : leaf_nodes) {
+        IndexPointer leaf_ptr;
+        leaf_ptr.Set(leaf_node.data);
+        auto &leaf = GetNode(leaf_ptr);
+        if (leaf.count >= RTreeNode::MIN_FILL) {
+            InsertEntry(leaf_node, 1);
+            continue;
+        }
+        auto entries = leaf.GetEntries();
+        FreeNode(leaf_ptr);
+        for (auto &entry : entries) {
+            InsertEntry(entry, 0);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Insert
+//------------------------------------------------------------------------------
+static idx_t ChooseSubtree(const RTreeNode &node, const RTreeBounds &bounds) {
+    // Least area enlargement, ties broken by the smaller area and then the smaller margin
+    idx_t best_idx = 0;
+    double best_enlargement = RTREE_INF;
+    double best_area = RTREE_INF;
+    double best_margin = RTREE_INF;
+    for (idx_t i = 0; i < node.count; i++) {
+        auto child = node.GetEntryBounds(i);
+        auto merged = child;
+        merged.Union(bounds);
+        auto area = child.Area();
+        auto enlargement = merged.Area() - area;
+        auto margin = merged.Margin();
+        if (enlargement < best_enlargement || (enlargement == best_enlargement && area < best_area) ||
+            (enlargement == best_enlargement && area == best_area && margin < best_margin)) {
+            best_idx = i;
+            best_enlargement = enlargement;
+            best_area = area;
+            best_margin = margin;
+        }
+    }
+    return best_idx;
+}
+
+RTreeEntry TRTree::SplitNode(IndexPointer node_ptr, const RTreeEntry &overflow) {
+    auto &node = GetNode(node_ptr);
+    const auto level = node.level;
+
+    auto entries = node.GetEntries();
+    entries.push_back(overflow);
+
+    // Pick the axis whose median split yields the smallest total margin
+    const auto half = entries.size() / 2;
+    idx_t best_axis = RTreeBounds::AXIS_X;
+    double best_margin = RTREE_INF;
+    for (auto axis : GetActiveAxes(entries.data(), entries.data() + entries.size())) {
+        SortByAxis(entries.data(), entries.data() + entries.size(), axis);
+        auto left = RTreeBounds::Empty();
+        auto right = RTreeBounds::Empty();
+        for (idx_t i = 0; i < entries.size(); i++) {
+            (i < half ? left : right).Union(entries[i].bounds);
+        }
+        auto margin = left.Margin() + right.Margin();
+        if (margin < best_margin) {
+            best_margin = margin;
+            best_axis = axis;
+        }
+    }
+    SortByAxis(entries.data(), entries.data() + entries.size(), best_axis);
+
+    auto sibling_ptr = NewNode(level);
+    auto &sibling = GetNode(sibling_ptr);
+    auto &target = GetNode(node_ptr);
+
+    target.SetEntries(entries.data(), half);
+    sibling.SetEntries(entries.data() + half, entries.size() - half);
+
+    return RTreeEntry(sibling.GetBounds(), sibling_ptr.Get());
+}
+
+bool TRTree::InsertRecursive(IndexPointer &node_ptr, const RTreeEntry &entry, uint32_t level, RTreeEntry &split) {
+    node_ptr = CopyOnWrite(node_ptr);
+    auto &node = GetNode(node_ptr);
+    if (node.level == level) {
+        if (node.count < RTreeNode::CAPACITY) {
+            node.Append(entry);
+            return false;
+        }
+        split = SplitNode(node_ptr, entry);
+        return true;
+    }
+
+    auto child_idx = ChooseSubtree(node, entry.bounds);
+    IndexPointer child_ptr;
+    child_ptr.Set(node.data[child_idx]);
+
+    RTreeEntry child_split;
+    auto child_was_split = InsertRecursive(child_ptr, entry, level, child_split);
+
+    // The child may have allocated nodes, fetch the node again
+    auto &parent = GetNode(node_ptr);
+    parent.data[child_idx] = child_ptr.Get();
+    if (!child_was_split) {
+        auto bounds = parent.GetEntryBounds(child_idx);
+        bounds.Union(entry.bounds);
+        parent.SetEntryBounds(child_idx, bounds);
+        return false;
+    }
+    parent.SetEntryBounds(child_idx, GetNode(child_ptr).GetBounds());
+    if (parent.count < RTreeNode::CAPACITY) {
+        parent.Append(child_split);
+        return false;
+    }
+    split = SplitNode(node_ptr, child_split);
+    return true;
+}
+
+void TRTree::Insert(const RTreeBounds &bounds, row_t row_id) {
+    InsertEntry(RTreeEntry(bounds, NumericCast<idx_t>(row_id)), 0);
+}
+
+void TRTree::InsertEntry(const RTreeEntry &entry, uint32_t level) {
+    if (IsEmpty()) {
+        root = NewNode(level);
+        GetNode(root).Append(entry);
+        return;
+    }
+
+    RTreeEntry split;
+    if (!InsertRecursive(root, entry, level, split)) {
+        return;
+    }
+
+    // The root was split, grow the tree by one level
+    auto &old_root = GetNode(root);
+    RTreeEntry old_root_entry(old_root.GetBounds(), root.Get());
+    auto new_root = NewNode(old_root.level + 1);
+    auto &node = GetNode(new_root);
+    node.Append(old_root_entry);
+    node.Append(split);
+    root = new_root;
+}
+
+//------------------------------------------------------------------------------
+// Delete
+//------------------------------------------------------------------------------
+static bool SameBounds(const RTreeBounds &a, const RTreeBounds &b) {
+    return memcmp(&a, &b, sizeof(RTreeBounds)) == 0;
+}
+
+bool TRTree::DeleteRecursive(IndexPointer &node_ptr, const RTreeEntry &entry,
+                             vector<pair<uint32_t, RTreeEntry>> &orphans) {
+    // Only the nodes on the path to the entry are copied, once it is found
+    auto &node = GetNodeReadOnly(node_ptr);
+    if (node.IsLeaf()) {
+        for (idx_t i = 0; i < node.count; i++) {
+            if (node.data[i] == entry.data && SameBounds(node.GetEntryBounds(i), entry.bounds)) {
+                node_ptr = CopyOnWrite(node_ptr);
+                GetNode(node_ptr).Remove(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Nothing is allocated before the entry is found, so the pinned node stays valid while searching
+    for (idx_t i = 0; i < node.count; i++) {
+        if (!node.GetEntryBounds(i).Contains(entry.bounds)) {
+            continue;
+        }
+        IndexPointer child_ptr;
+        child_ptr.Set(node.data[i]);
+        if (!DeleteRecursive(child_ptr, entry, orphans)) {
+            continue;
+        }
+
+        node_ptr = CopyOnWrite(node_ptr);
+        auto &parent = GetNode(node_ptr);
+        auto &child = GetNode(child_ptr);
+        if (child.count >= RTreeNode::MIN_FILL) {
+            parent.data[i] = child_ptr.Get();
+            parent.SetEntryBounds(i, child.GetBounds());
+            return true;
+        }
+        // Condense: unlink the underfull child, its entries are reinserted at its level
+        for (idx_t j = 0; j < child.count; j++) {
+            orphans.emplace_back(child.level, child.GetEntry(j));
+        }
+        FreeNode(child_ptr);
+        parent.Remove(i);
+        return true;
+    }
+    return false;
+}
+
+bool TRTree::Delete(const RTreeBounds &bounds, row_t row_id) {
+    if (IsEmpty()) {
+        return false;
+    }
+    vector<pair<uint32_t, RTreeEntry>> orphans;
+    if (!DeleteRecursive(root, RTreeEntry(bounds, NumericCast<idx_t>(row_id)), orphans)) {
+        return false;
+    }
+    if (GetNodeReadOnly(root).count == 0) {
+        FreeNode(root);
+        root.Clear();
+    }
+
+    // Reinsert the subtrees of higher levels first, an empty tree grows back from the highest one
+    std::stable_sort(orphans.begin(), orphans.end(),
+                     [](const pair<uint32_t, RTreeEntry> &a, const pair<uint32_t, RTreeEntry> &b) {
+                         return a.first > b.first;
+                     });
+    for (auto &orphan : orphans) {
+        InsertEntry(orphan.second, orphan.first);
+    }
+
+    // Shorten the tree while the root is a branch with a single child
+    while (!IsEmpty()) {
+        auto &root_node = GetNodeReadOnly(root);
+        if (root_node.IsLeaf() || root_node.count > 1) {
+            break;
+        }
+        IndexPointer child;
+        child.Set(root_node.data[0]);
+        FreeNode(root);
+        root = child;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Search
+//------------------------------------------------------------------------------
+//! Position of the lowest entry of a bitmask of entries
+static idx_t FirstEntry(const uint64_t mask) {
+    D_ASSERT(mask != 0);
+    return NumericCast<idx_t>(CountZeros<uint64_t>::Trailing(mask));
+}
+
+static idx_t CountEntries(uint64_t mask) {
+    idx_t count = 0;
+    for (; mask; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+void TRTree::Search(const RTreeBounds &query, vector<row_t> &result) const {
+    if (IsEmpty()) {
+        return;
+    }
+    vector<IndexPointer> stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+
+        auto &node = GetNodeReadOnly(ptr);
+        for (auto hits = node.Intersecting(query); hits; hits &= hits - 1) {
+            const auto i = FirstEntry(hits);
+            if (node.IsLeaf()) {
+                result.push_back(NumericCast<row_t>(node.data[i]));
+            } else {
+                IndexPointer child;
+                child.Set(node.data[i]);
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+//! Whether the subtree below a branch entry can hold a match
+static bool MatchesBranch(const RTreeBounds &bounds, const RTreeCursor &cursor) {
+    switch (cursor.predicate) {
+    case RTreePredicate::CONTAINS:
+        return bounds.Contains(cursor.query);
+    default:
+        return bounds.Intersects(cursor.query);
+    }
+}
+
+bool TRTree::MatchesLeaf(const RTreeBounds &bounds, const RTreeCursor &cursor) {
+    switch (cursor.predicate) {
+    case RTreePredicate::CONTAINS:
+        return bounds.Contains(cursor.query);
+    case RTreePredicate::CONTAINED_BY: {
+        auto &query = cursor.query;
+        return (!bounds.HasAxis(RTreeBounds::AXIS_X) || (query.xmin <= bounds.xmin && bounds.xmax <= query.xmax)) &&
+               (!bounds.HasAxis(RTreeBounds::AXIS_Y) || (query.ymin <= bounds.ymin && bounds.ymax <= query.ymax)) &&
+               (!bounds.HasAxis(RTreeBounds::AXIS_Z) || (query.zmin <= bounds.zmin && bounds.zmax <= query.zmax)) &&
+               (!bounds.HasAxis(RTreeBounds::AXIS_T) || (query.tmin <= bounds.tmin && bounds.tmax <= query.tmax));
+    }
+    default:
+        return bounds.Intersects(cursor.query);
+    }
+}
+
+//! Entries of the node that the cursor visits: the subtrees that can hold a match in a branch, the matches in a leaf
+static uint64_t MatchingEntries(const RTreeNode &node, const RTreeCursor &cursor) {
+    // Overlap, and containment in the query above the leaves, is the plain intersection test of the kernel
+    if (cursor.predicate == RTreePredicate::OVERLAPS ||
+        (cursor.predicate == RTreePredicate::CONTAINED_BY && !node.IsLeaf())) {
+        return node.Intersecting(cursor.query);
+    }
+    uint64_t result = 0;
+    for (idx_t i = 0; i < node.count; i++) {
+        const auto bounds = node.GetEntryBounds(i);
+        if (node.IsLeaf() ? TRTree::MatchesLeaf(bounds, cursor) : MatchesBranch(bounds, cursor)) {
+            result |= uint64_t(1) << i;
+        }
+    }
+    return result;
+}
+
+void TRTree::InitializeScan(RTreeCursor &cursor, const RTreeBounds &query, RTreePredicate predicate) const {
+    cursor.query = query;
+    cursor.predicate = predicate;
+    if (predicate == RTreePredicate::CONTAINS) {
+        // An axis the query does not have is contained in every box, so it is collapsed to an empty range
+        auto empty = RTreeBounds::Empty();
+        if (!query.HasAxis(RTreeBounds::AXIS_X)) {
+            cursor.query.xmin = empty.xmin;
+            cursor.query.xmax = empty.xmax;
+        }
+        if (!query.HasAxis(RTreeBounds::AXIS_Y)) {
+            cursor.query.ymin = empty.ymin;
+            cursor.query.ymax = empty.ymax;
+        }
+        if (!query.HasAxis(RTreeBounds::AXIS_Z)) {
+            cursor.query.zmin = empty.zmin;
+            cursor.query.zmax = empty.zmax;
+        }
+        if (!query.HasAxis(RTreeBounds::AXIS_T)) {
+            cursor.query.tmin = empty.tmin;
+            cursor.query.tmax = empty.tmax;
+        }
+    }
+    cursor.stack.clear();
+    cursor.snapshot.reset();
+    if (!IsEmpty()) {
+        auto pending = MatchingEntries(GetNodeReadOnly(root), cursor);
+        if (pending) {
+            cursor.stack.push_back({root, pending});
+            cursor.snapshot = OpenSnapshot();
+        }
+    }
+}
+
+idx_t TRTree::Scan(RTreeCursor &cursor, row_t *result, idx_t capacity) const {
+    idx_t result_count = 0;
+    while (!cursor.stack.empty() && result_count < capacity) {
+        auto &frame = cursor.stack.back();
+        if (!frame.pending) {
+            cursor.stack.pop_back();
+            continue;
+        }
+        auto &node = GetNodeReadOnly(frame.node);
+
+        if (node.IsLeaf()) {
+            for (; frame.pending && result_count < capacity; frame.pending &= frame.pending - 1) {
+                result[result_count++] = NumericCast<row_t>(node.data[FirstEntry(frame.pending)]);
+            }
+            continue;
+        }
+
+        // Descend into the next matching child, resuming with its sibling afterwards
+        IndexPointer child;
+        child.Set(node.data[FirstEntry(frame.pending)]);
+        frame.pending &= frame.pending - 1;
+        auto pending = MatchingEntries(GetNodeReadOnly(child), cursor);
+        if (pending) {
+            cursor.stack.push_back({child, pending});
+        }
+    }
+    if (cursor.stack.empty()) {
+        cursor.snapshot.reset();
+    }
+    return result_count;
+}
+
+void TRTree::InitializeBatchScan(RTreeBatchCursor &cursor, vector<RTreeBounds> queries) const {
+    cursor.queries = std::move(queries);
+    cursor.stack.clear();
+    cursor.snapshot.reset();
+    if (IsEmpty() || cursor.queries.empty()) {
+        return;
+    }
+    cursor.snapshot = OpenSnapshot();
+    RTreeBatchCursor::Frame frame {root, 0, 0, {}, {}};
+    frame.active.reserve(cursor.queries.size());
+    for (idx_t i = 0; i < cursor.queries.size(); i++) {
+        frame.active.push_back(NumericCast<uint32_t>(i));
+    }
+    cursor.stack.push_back(std::move(frame));
+}
+
+idx_t TRTree::BatchScan(RTreeBatchCursor &cursor, uint32_t *query_ids, row_t *row_ids, idx_t capacity) const {
+    idx_t result_count = 0;
+    vector<uint32_t> child_active;
+    while (!cursor.stack.empty() && result_count < capacity) {
+        auto &frame = cursor.stack.back();
+        auto &node = GetNodeReadOnly(frame.node);
+        if (frame.hits.empty()) {
+            // One kernel call per active query tests all entries of the node
+            frame.hits.reserve(frame.active.size());
+            for (auto query_idx : frame.active) {
+                frame.hits.push_back(node.Intersecting(cursor.queries[query_idx]));
+            }
+        }
+
+        if (node.IsLeaf()) {
+            // Emit the pairs query by query, the emitted entries are cleared from the hits of the query
+            while (frame.next_query < frame.active.size() && result_count < capacity) {
+                auto &hits = frame.hits[frame.next_query];
+                for (; hits && result_count < capacity; hits &= hits - 1) {
+                    query_ids[result_count] = frame.active[frame.next_query];
+                    row_ids[result_count++] = NumericCast<row_t>(node.data[FirstEntry(hits)]);
+                }
+                if (!hits) {
+                    frame.next_query++;
+                }
+            }
+            if (frame.next_query == frame.active.size()) {
+                cursor.stack.pop_back();
+            }
+            continue;
+        }
+
+        // Descend into the next child some active query intersects, with the queries that do
+        IndexPointer child;
+        child_active.clear();
+        while (frame.next_entry < node.count && child_active.empty()) {
+            const auto entry_bit = uint64_t(1) << frame.next_entry;
+            for (idx_t i = 0; i < frame.active.size(); i++) {
+                if (frame.hits[i] & entry_bit) {
+                    child_active.push_back(frame.active[i]);
+                }
+            }
+            if (!child_active.empty()) {
+                child.Set(node.data[frame.next_entry]);
+            }
+            frame.next_entry++;
+        }
+        if (frame.next_entry == node.count) {
+            cursor.stack.pop_back();
+        }
+        if (child) {
+            cursor.stack.push_back({child, 0, 0, std::move(child_active), {}});
+            child_active = vector<uint32_t>();
+        }
+    }
+    if (cursor.stack.empty()) {
+        cursor.snapshot.reset();
+    }
+    return result_count;
+}
+
+void TRTree::InitializeNearestScan(RTreeNearestCursor &cursor, const RTreeBounds &query) const {
+    cursor.query = query;
+    cursor.queue = {};
+    cursor.snapshot.reset();
+    if (!IsEmpty()) {
+        cursor.queue.push({0, root.Get(), false});
+        cursor.snapshot = OpenSnapshot();
+    }
+}
+
+idx_t TRTree::NearestScan(RTreeNearestCursor &cursor, row_t *result, idx_t capacity) const {
+    idx_t result_count = 0;
+    while (!cursor.queue.empty() && result_count < capacity) {
+        const auto candidate = cursor.queue.top();
+        cursor.queue.pop();
+
+        // A row is only popped once every node that could hold something nearer has been expanded
+        if (candidate.is_row) {
+            result[result_count++] = NumericCast<row_t>(candidate.data);
+            continue;
+        }
+
+        IndexPointer node_ptr;
+        node_ptr.Set(candidate.data);
+        auto &node = GetNodeReadOnly(node_ptr);
+        for (idx_t i = 0; i < node.count; i++) {
+            cursor.queue.push({node.GetEntryBounds(i).MinDistance(cursor.query), node.data[i], node.IsLeaf()});
+        }
+    }
+    if (cursor.queue.empty()) {
+        cursor.snapshot.reset();
+    }
+    return result_count;
+}
+
+//------------------------------------------------------------------------------
+// Estimation
+//------------------------------------------------------------------------------
+//! Fraction of the extent of the box on one axis that lies within the query, 1 if the extent is not finite
+static double AxisOverlap(double lower, double upper, double query_lower, double query_upper) {
+    const auto extent = upper - lower;
+    if (!(extent > 0) || std::isinf(extent)) {
+        return 1;
+    }
+    const auto overlap = MinValue(upper, query_upper) - MaxValue(lower, query_lower);
+    return MaxValue(0.0, MinValue(1.0, overlap / extent));
+}
+
+//! Fraction of the box that lies within the query, assuming its content is spread uniformly
+static double OverlapFraction(const RTreeBounds &box, const RTreeBounds &query) {
+    return AxisOverlap(box.xmin, box.xmax, query.xmin, query.xmax) *
+           AxisOverlap(box.ymin, box.ymax, query.ymin, query.ymax) *
+           AxisOverlap(box.zmin, box.zmax, query.zmin, query.zmax) *
+           AxisOverlap(static_cast<double>(box.tmin), static_cast<double>(box.tmax),
+                       static_cast<double>(query.tmin), static_cast<double>(query.tmax));
+}
+
+double TRTree::EstimateCount(const RTreeBounds &query, idx_t node_budget) const {
+    if (IsEmpty()) {
+        return 0;
+    }
+    struct Subtree {
+        IndexPointer node;
+        uint32_t level;
+        double fraction;
+    };
+
+    double result = 0;
+    idx_t node_count = 0;
+    idx_t entry_count = 0;
+    vector<Subtree> unread;
+    vector<Subtree> queue;
+    queue.push_back({root, GetNodeReadOnly(root).level, 1});
+    for (idx_t i = 0; i < queue.size(); i++) {
+        // The root is always read, so that the fanout is known
+        if (node_count > 0 && node_count >= node_budget) {
+            unread.push_back(queue[i]);
+            continue;
+        }
+        auto &node = GetNodeReadOnly(queue[i].node);
+        node_count++;
+        entry_count += node.count;
+        auto hits = node.Intersecting(query);
+        if (node.IsLeaf()) {
+            result += static_cast<double>(CountEntries(hits));
+            continue;
+        }
+        for (; hits; hits &= hits - 1) {
+            const auto j = FirstEntry(hits);
+            IndexPointer child;
+            child.Set(node.data[j]);
+            queue.push_back({child, node.level - 1, OverlapFraction(node.GetEntryBounds(j), query)});
+        }
+    }
+
+    const auto fanout = static_cast<double>(entry_count) / static_cast<double>(node_count);
+    for (auto &subtree : unread) {
+        result += subtree.fraction * std::pow(fanout, subtree.level + 1);
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Verification
+//------------------------------------------------------------------------------
+idx_t TRTree::VerifyNode(IndexPointer node_ptr, uint32_t expected_level, const RTreeBounds *parent_bounds) const {
+    auto &node = GetNodeReadOnly(node_ptr);
+    if (node.level != expected_level) {
+        throw InternalException("TRTREE node has level %d, expected %d", node.level, expected_level);
+    }
+    if (node.count == 0 || node.count > RTreeNode::CAPACITY) {
+        throw InternalException("TRTREE node has invalid entry count %d", node.count);
+    }
+    if (parent_bounds && !parent_bounds->Contains(node.GetBounds())) {
+        throw InternalException("TRTREE node is not covered by the bounds of its parent entry");
+    }
+    idx_t node_count = 1;
+    if (node.IsLeaf()) {
+        return node_count;
+    }
+    for (idx_t i = 0; i < node.count; i++) {
+        IndexPointer child;
+        child.Set(node.data[i]);
+        auto bounds = node.GetEntryBounds(i);
+        node_count += VerifyNode(child, expected_level - 1, &bounds);
+    }
+    return node_count;
+}
+
+idx_t TRTree::Verify() const {
+    if (IsEmpty()) {
+        return 0;
+    }
+    auto &root_node = GetNodeReadOnly(root);
+    return VerifyNode(root, root_node.level, nullptr);
+}
+
+string TRTree::ToString(bool summary_only) const {
+    if (IsEmpty()) {
+        return "TRTREE (empty)";
+    }
+    // Only list individual nodes for small trees
+    static constexpr idx_t MAX_LISTED_NODES = 64;
+
+    auto &root_node = GetNodeReadOnly(root);
+    const auto height = root_node.level + 1;
+    vector<idx_t> nodes_per_level(height, 0);
+    idx_t entry_count = 0;
+    string node_list;
+
+    vector<IndexPointer> stack;
+    stack.push_back(root);
+    idx_t listed = 0;
+    while (!stack.empty()) {
+        auto ptr = stack.back();
+        stack.pop_back();
+        auto &node = GetNodeReadOnly(ptr);
+        nodes_per_level[node.level]++;
+        if (!summary_only && listed++ < MAX_LISTED_NODES) {
+            node_list += StringUtil::Format("\n%s[level %d] %d entries", string(2 * (height - 1 - node.level), ' '),
+                                            node.level, node.count);
+        }
+        if (node.IsLeaf()) {
+            entry_count += node.count;
+            continue;
+        }
+        for (idx_t i = 0; i < node.count; i++) {
+            IndexPointer child;
+            child.Set(node.data[i]);
+            stack.push_back(child);
+        }
+    }
+
+    auto result = StringUtil::Format("TRTREE height %d, %d entries, nodes per level:", height, entry_count);
+    for (idx_t level = height; level > 0; level--) {
+        result += StringUtil::Format(" %d", nodes_per_level[level - 1]);
+    }
+    return result + node_list;
+}
+
+} // namespace duckdb
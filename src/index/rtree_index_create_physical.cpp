@@ -10,6 +10,8 @@
 #include "duckdb/storage/table_io_manager.hpp"
 #include "duckdb/parallel/base_pipeline_event.hpp"
 
+#include <algorithm>
+
 #include "index/rtree_module.hpp"
 
 namespace duckdb {
@@ -44,9 +46,14 @@ public:
 	unique_ptr<RTreeIndex> global_index;
 
 	mutex glock;
-	unique_ptr<ColumnDataCollection> collection;
 	shared_ptr<ClientContext> context;
-	ColumnDataParallelScanState scan_state;
+
+	//! Leaf entries of every sink thread
+	vector<vector<RTreeEntry>> sink_entries;
+	//! Leaf entries bucketed into spatial slabs, one construction task per slab
+	vector<vector<RTreeEntry>> slabs;
+	//! Leaves packed by each construction task, merged once all tasks finish
+	vector<unique_ptr<RTreePartition>> partitions;
 
 	atomic<bool> is_building = {false};
 	atomic<idx_t> loaded_count = {0};
@@ -57,8 +64,6 @@ unique_ptr<GlobalSinkState> PhysicalCreateRTreeIndex::GetGlobalSinkState(ClientC
 
 	auto gstate = make_uniq<CreateRTreeIndexGlobalState>(*this);
 
-	vector<LogicalType> data_types = {unbound_expressions[0]->return_type, LogicalType::ROW_TYPE};
-	gstate->collection = make_uniq<ColumnDataCollection>(BufferManager::GetBufferManager(context), data_types);
 	gstate->context = context.shared_from_this();
 
 	// Create the index
@@ -79,17 +84,13 @@ unique_ptr<GlobalSinkState> PhysicalCreateRTreeIndex::GetGlobalSinkState(ClientC
 //-------------------------------------------------------------
 class CreateRTreeIndexLocalState final : public LocalSinkState {
 public:
-	unique_ptr<ColumnDataCollection> collection;
-	ColumnDataAppendState append_state;
+	vector<RTreeEntry> entries;
+	//! Reference system and dimensions of the boxes of this thread
+	RTreeSpace space;
 };
 
 unique_ptr<LocalSinkState> PhysicalCreateRTreeIndex::GetLocalSinkState(ExecutionContext &context) const {
-	auto state = make_uniq<CreateRTreeIndexLocalState>();
-
-	vector<LogicalType> data_types = {unbound_expressions[0]->return_type, LogicalType::ROW_TYPE};
-	state->collection = make_uniq<ColumnDataCollection>(BufferManager::GetBufferManager(context.client), data_types);
-	state->collection->InitializeAppend(state->append_state);
-	return std::move(state);
+	return make_uniq<CreateRTreeIndexLocalState>();
 }
 
 //-------------------------------------------------------------
@@ -101,7 +102,14 @@ SinkResultType PhysicalCreateRTreeIndex::Sink(ExecutionContext &context, DataChu
 
 	auto &lstate = input.local_state.Cast<CreateRTreeIndexLocalState>();
 	auto &gstate = input.global_state.Cast<CreateRTreeIndexGlobalState>();
-	lstate.collection->Append(lstate.append_state, chunk);
+
+	auto &box_vector = chunk.data[0];
+	auto &rowid_vector = chunk.data[1];
+	if (box_vector.GetType().id() != LogicalTypeId::BLOB) {
+		throw InvalidInputException("Unsupported data type for RTree index: %s", box_vector.GetType().ToString());
+	}
+	gstate.global_index->GetEntries(box_vector, rowid_vector, chunk.size(), lstate.entries, lstate.space);
+
 	gstate.loaded_count += chunk.size();
 	return SinkResultType::NEED_MORE_INPUT;
 }
@@ -114,16 +122,13 @@ SinkCombineResultType PhysicalCreateRTreeIndex::Combine(ExecutionContext &contex
 	auto &gstate = input.global_state.Cast<CreateRTreeIndexGlobalState>();
 	auto &lstate = input.local_state.Cast<CreateRTreeIndexLocalState>();
 
-	if (lstate.collection->Count() == 0) {
+	if (lstate.entries.empty()) {
 		return SinkCombineResultType::FINISHED;
 	}
 
 	lock_guard<mutex> l(gstate.glock);
-	if (!gstate.collection) {
-		gstate.collection = std::move(lstate.collection);
-	} else {
-		gstate.collection->Combine(*lstate.collection);
-	}
+	gstate.global_index->MergeSpace(lstate.space);
+	gstate.sink_entries.push_back(std::move(lstate.entries));
 
 	return SinkCombineResultType::FINISHED;
 }
@@ -135,130 +140,29 @@ SinkCombineResultType PhysicalCreateRTreeIndex::Combine(ExecutionContext &contex
 class RTreeIndexConstructTask final : public ExecutorTask {
 public:
 	RTreeIndexConstructTask(shared_ptr<Event> event_p, ClientContext &context, CreateRTreeIndexGlobalState &gstate_p,
-	                       size_t thread_id_p, const PhysicalCreateRTreeIndex &op_p)
-	    : ExecutorTask(context, std::move(event_p), op_p), gstate(gstate_p), thread_id(thread_id_p),
-	      local_scan_state() {
-		gstate.collection->InitializeScanChunk(scan_chunk);
+	                       size_t slab_idx_p, const PhysicalCreateRTreeIndex &op_p)
+	    : ExecutorTask(context, std::move(event_p), op_p), gstate(gstate_p), slab_idx(slab_idx_p) {
 	}
 
 	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
 
-		auto &scan_state = gstate.scan_state;
-		auto &collection = gstate.collection;
-
-		while (collection->Scan(scan_state, local_scan_state, scan_chunk)) {
-
-			const auto count = scan_chunk.size();
-
-			auto &vec_vec = scan_chunk.data[0];  
-			auto &rowid_vec = scan_chunk.data[1]; 
-
-			auto vector_type = vec_vec.GetType();
-			
-			if (vec_vec.GetVectorType() != VectorType::FLAT_VECTOR) {
-				vec_vec.Flatten(count);
-			}
-			if (rowid_vec.GetVectorType() != VectorType::FLAT_VECTOR) {
-				rowid_vec.Flatten(count);
-			}
-
-			UnifiedVectorFormat vec_format;
-			UnifiedVectorFormat rowid_format;
-
-			vec_vec.ToUnifiedFormat(count, vec_format);
-			rowid_vec.ToUnifiedFormat(count, rowid_format);
-
-			const auto row_ptr = UnifiedVectorFormat::GetData<row_t>(rowid_format);
-			STBox* boxes = (STBox*)malloc(sizeof(STBox) * count);
-			if (!boxes) {
-				executor.PushError(ErrorData("Failed to allocate memory for STBox array"));
-				return TaskExecutionResult::TASK_ERROR;
-			}
-
-			idx_t valid_count = 0;
-			vector<row_t> valid_row_ids;
-
-			for (idx_t i = 0; i < count; i++) {
-				const auto vec_idx = vec_format.sel->get_index(i);
-				const auto row_idx = rowid_format.sel->get_index(i);
-
-				const auto vec_valid = vec_format.validity.RowIsValid(vec_idx);
-				const auto rowid_valid = rowid_format.validity.RowIsValid(row_idx);
-				
-				if (!vec_valid || !rowid_valid) {
-					continue;
-				}
-
-				fprintf(stderr, "Processing row %zu (vec_idx=%zu, row_idx=%zu)\n", i, vec_idx, row_idx);
-
-				STBox *box = nullptr;
-				
-				if (vector_type.id() == LogicalTypeId::BLOB) {
-					
-					const auto stbox_data_ptr = UnifiedVectorFormat::GetData<string_t>(vec_format);
-					auto blob_data = stbox_data_ptr[vec_idx];
-					const uint8_t *stbox_bytes = reinterpret_cast<const uint8_t*>(blob_data.GetData());
-					size_t stbox_size = blob_data.GetSize();
-					box = (STBox*)malloc(stbox_size);
-					memcpy(box, stbox_bytes, stbox_size);
-
-					int32_t box_srid = stbox_srid(box);
-					
-					if (box_srid != 0) {
-						STBox *normalized_box = stbox_set_srid(box, 0);
-						if (normalized_box) {
-							free(box);
-							box = normalized_box;
-						}
-					}
-					
-					// Copy to our batch array
-					memcpy(&boxes[valid_count], box, sizeof(STBox));
-					valid_row_ids.push_back(row_ptr[row_idx]);
-					valid_count++;
-					
-					free(box);
-					
-					
-				}
-				else {
-					free(boxes);
-					executor.PushError(ErrorData("Unsupported data type for RTree index: " + vector_type.ToString()));
-					return TaskExecutionResult::TASK_ERROR;
-				}
-			}
-
-			// Now batch insert the valid STBoxes into the index
-			if (valid_count > 0) {
-				auto &rtree_index = gstate.global_index;
-				
-				auto result = rtree_index->BulkConstruct(boxes, valid_row_ids.data(), valid_count);
-				if (result.HasError()) {
-					free(boxes);
-					executor.PushError(result);
-					return TaskExecutionResult::TASK_ERROR;
-				}
-				
-			}
-
-			free(boxes);
-
-			gstate.built_count += count;
-
-			if (mode == TaskExecutionMode::PROCESS_PARTIAL) {
-				return TaskExecutionResult::TASK_NOT_FINISHED;
-			}
+		// Each slab is packed into a private tree, the merge happens in FinishEvent
+		auto &slab = gstate.slabs[slab_idx];
+		const auto count = slab.size();
+		auto partition = gstate.global_index->PackPartition(slab);
+		{
+			lock_guard<mutex> l(gstate.glock);
+			gstate.partitions.push_back(std::move(partition));
 		}
+		gstate.built_count += count;
+
 		event->FinishTask();
 		return TaskExecutionResult::TASK_FINISHED;
 	}
 
 private:
 	CreateRTreeIndexGlobalState &gstate;
-	size_t thread_id;
-
-	DataChunk scan_chunk;
-	ColumnDataLocalScanState local_scan_state;
+	size_t slab_idx;
 };
 
 class RTreeIndexConstructionEvent final : public BasePipelineEvent {
@@ -281,12 +185,10 @@ public:
 	void Schedule() override {
 		auto &context = pipeline->GetClientContext();
 
-		auto &ts = TaskScheduler::GetScheduler(context);
-		const auto num_threads = NumericCast<size_t>(ts.NumberOfThreads());
-
 		vector<shared_ptr<Task>> construct_tasks;
-		for (size_t tnum = 0; tnum < num_threads; tnum++) {
-			construct_tasks.push_back(make_uniq<RTreeIndexConstructTask>(shared_from_this(), context, gstate, tnum, op));
+		for (size_t slab_idx = 0; slab_idx < gstate.slabs.size(); slab_idx++) {
+			construct_tasks.push_back(
+			    make_uniq<RTreeIndexConstructTask>(shared_from_this(), context, gstate, slab_idx, op));
 		}
 		SetTasks(std::move(construct_tasks));
 	}
@@ -295,14 +197,19 @@ public:
 
 		auto &storage = table.GetStorage();
 
+		auto result = gstate.global_index->MergePartitions(gstate.partitions);
+		if (result.HasError()) {
+			result.Throw();
+		}
 
 		if (!storage.IsRoot()) {
 			throw TransactionException("Cannot create index on non-root transaction");
 		}
 
-		// Create the index entry in the catalog
+		// Create the index entry in the catalog, keeping the reference system and dimensions of the boxes
 		auto &schema = table.schema;
 		info.column_ids = storage_ids;
+		gstate.global_index->GetSpace().Serialize(info.options);
 
 		if (schema.GetEntry(schema.GetCatalogTransaction(*gstate.context), CatalogType::INDEX_ENTRY, info.index_name)) {
 			if (info.on_conflict != OnCreateConflict::IGNORE_ON_CONFLICT) {
@@ -319,17 +226,74 @@ public:
 	}
 };
 
+//! Bucket the entries into slabs along the first axis the boxes are bounded on, so that every construction task
+//! packs a spatially disjoint part of the data. The slab boundaries are the quantiles of a sample of the box centers.
+static void PartitionIntoSlabs(CreateRTreeIndexGlobalState &gstate, idx_t slab_count) {
+	idx_t total_count = 0;
+	for (auto &entries : gstate.sink_entries) {
+		total_count += entries.size();
+	}
+	// Avoid slabs so small that their leaves cannot be packed well
+	static constexpr idx_t MIN_SLAB_SIZE = RTreeNode::CAPACITY * RTreeNode::CAPACITY;
+	slab_count = MaxValue<idx_t>(1, MinValue<idx_t>(slab_count, total_count / MIN_SLAB_SIZE));
+
+	vector<double> boundaries;
+	idx_t axis = RTreeBounds::AXIS_X;
+	if (slab_count > 1) {
+		static constexpr idx_t SAMPLES_PER_SLAB = 256;
+		const auto stride = MaxValue<idx_t>(1, total_count / (slab_count * SAMPLES_PER_SLAB));
+		vector<RTreeEntry> sample;
+		idx_t position = 0;
+		for (auto &entries : gstate.sink_entries) {
+			for (auto &entry : entries) {
+				if (position++ % stride == 0) {
+					sample.push_back(entry);
+				}
+			}
+		}
+		// Time-only boxes have no X extent to cut along
+		axis = TRTree::GetActiveAxes(sample.data(), sample.data() + sample.size())[0];
+		vector<double> centers;
+		centers.reserve(sample.size());
+		for (auto &entry : sample) {
+			centers.push_back(entry.bounds.Center(axis));
+		}
+		std::sort(centers.begin(), centers.end());
+		for (idx_t i = 1; i < slab_count; i++) {
+			boundaries.push_back(centers[i * centers.size() / slab_count]);
+		}
+	}
+
+	gstate.slabs.resize(slab_count);
+	for (auto &entries : gstate.sink_entries) {
+		if (slab_count == 1 && gstate.slabs[0].empty()) {
+			gstate.slabs[0] = std::move(entries);
+		} else if (slab_count == 1) {
+			gstate.slabs[0].insert(gstate.slabs[0].end(), entries.begin(), entries.end());
+		} else {
+			for (auto &entry : entries) {
+				const auto center = entry.bounds.Center(axis);
+				const auto slab_idx = NumericCast<idx_t>(
+				    std::upper_bound(boundaries.begin(), boundaries.end(), center) - boundaries.begin());
+				gstate.slabs[slab_idx].push_back(entry);
+			}
+		}
+		// Release the memory of the sink buffer as soon as it is distributed
+		vector<RTreeEntry>().swap(entries);
+	}
+	gstate.sink_entries.clear();
+}
+
 SinkFinalizeType PhysicalCreateRTreeIndex::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
                                                    OperatorSinkFinalizeInput &input) const {
 	
 
 	auto &gstate = input.global_state.Cast<CreateRTreeIndexGlobalState>();
-	auto &collection = gstate.collection;
 
 	gstate.is_building = true;
 
 	auto &ts = TaskScheduler::GetScheduler(context);
-	collection->InitializeScan(gstate.scan_state, ColumnDataScanProperties::ALLOW_ZERO_COPY);
+	PartitionIntoSlabs(gstate, NumericCast<idx_t>(ts.NumberOfThreads()));
 
 	auto new_event = make_shared_ptr<RTreeIndexConstructionEvent>(*this, gstate, pipeline, *info, storage_ids, table);
 	event.InsertEvent(std::move(new_event));
@@ -342,7 +306,7 @@ ProgressData PhysicalCreateRTreeIndex::GetSinkProgress(ClientContext &context, G
 	ProgressData res;
 
 	const auto &state = gstate.Cast<CreateRTreeIndexGlobalState>();
-	// First half of the progress is appending to the collection
+	// First half of the progress is gathering the entries
 	if (!state.is_building) {
 		res.done = state.loaded_count + 0.0;
 		res.total = estimated_cardinality + estimated_cardinality;
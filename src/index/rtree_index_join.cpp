@@ -0,0 +1,388 @@
+#include "meos_wrapper_simple.hpp"
+#include "index/rtree_index_join.hpp"
+#include "duckdb/catalog/catalog_entry/duck_table_entry.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/column_binding_map.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/operator/logical_any_join.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/storage/data_table.hpp"
+#include "duckdb/storage/table/scan_state.hpp"
+#include "duckdb/transaction/duck_transaction.hpp"
+#include "duckdb/transaction/local_storage.hpp"
+
+#include "index/rtree_module.hpp"
+#include "geo/stbox.hpp"
+
+namespace duckdb {
+
+//-------------------------------------------------------------
+// Logical RTree Index Join
+//-------------------------------------------------------------
+LogicalRTreeIndexJoin::LogicalRTreeIndexJoin(DuckTableEntry &table_p, RTreeIndex &index_p,
+                                             vector<ColumnIndex> column_ids_p, vector<ColumnBinding> inner_bindings_p,
+                                             vector<LogicalType> inner_types_p, unique_ptr<Expression> probe)
+    : table(table_p), index(index_p), column_ids(std::move(column_ids_p)), inner_bindings(std::move(inner_bindings_p)),
+      inner_types(std::move(inner_types_p)) {
+	// The probe is resolved against the bindings of the outer child
+	expressions.push_back(std::move(probe));
+}
+
+vector<ColumnBinding> LogicalRTreeIndexJoin::GetColumnBindings() {
+	auto result = children[0]->GetColumnBindings();
+	result.insert(result.end(), inner_bindings.begin(), inner_bindings.end());
+	return result;
+}
+
+void LogicalRTreeIndexJoin::ResolveTypes() {
+	types = children[0]->types;
+	types.insert(types.end(), inner_types.begin(), inner_types.end());
+}
+
+PhysicalOperator &LogicalRTreeIndexJoin::CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) {
+	auto &outer = planner.CreatePlan(*children[0]);
+
+	vector<StorageIndex> storage_ids;
+	for (auto &id : column_ids) {
+		if (id.IsRowIdColumn()) {
+			storage_ids.emplace_back(COLUMN_IDENTIFIER_ROW_ID);
+		} else {
+			storage_ids.emplace_back(table.GetColumn(LogicalIndex(id.GetPrimaryIndex())).StorageOid());
+		}
+	}
+	storage_ids.emplace_back(COLUMN_IDENTIFIER_ROW_ID);
+
+	auto fetch_types = inner_types;
+	fetch_types.emplace_back(LogicalType::ROW_TYPE);
+
+	auto &join = planner.Make<PhysicalRTreeIndexJoin>(types, table, index, std::move(storage_ids),
+	                                                  std::move(fetch_types), std::move(expressions[0]),
+	                                                  estimated_cardinality);
+	join.children.push_back(outer);
+	return join;
+}
+
+//-------------------------------------------------------------
+// Physical RTree Index Join
+//-------------------------------------------------------------
+PhysicalRTreeIndexJoin::PhysicalRTreeIndexJoin(const vector<LogicalType> &types_p, DuckTableEntry &table_p,
+                                               RTreeIndex &index_p, vector<StorageIndex> storage_ids_p,
+                                               vector<LogicalType> fetch_types_p, unique_ptr<Expression> probe_p,
+                                               idx_t estimated_cardinality)
+    : PhysicalOperator(PhysicalOperatorType::EXTENSION, types_p, estimated_cardinality), table(table_p),
+      index(index_p), storage_ids(std::move(storage_ids_p)), fetch_types(std::move(fetch_types_p)),
+      probe(std::move(probe_p)) {
+}
+
+InsertionOrderPreservingMap<string> PhysicalRTreeIndexJoin::ParamsToString() const {
+	InsertionOrderPreservingMap<string> result;
+	result["Table"] = table.name;
+	result["Index"] = index.name;
+	result["Probe"] = probe->GetName();
+	SetEstimatedCardinality(result, estimated_cardinality);
+	return result;
+}
+
+class RTreeIndexJoinState : public OperatorState {
+public:
+	RTreeIndexJoinState(ClientContext &context, const PhysicalRTreeIndexJoin &op)
+	    : executor(context, *op.probe), request_sel(STANDARD_VECTOR_SIZE), result_sel(STANDARD_VECTOR_SIZE) {
+		probe_boxes.Initialize(Allocator::Get(context), {op.probe->return_type});
+		matches.Initialize(Allocator::Get(context), {LogicalType::UINTEGER, LogicalType::ROW_TYPE});
+		fetched.Initialize(Allocator::Get(context), op.fetch_types);
+	}
+
+	ExpressionExecutor executor;
+	DataChunk probe_boxes;
+	//! The search of all probes of the current input chunk, null until they have been evaluated
+	unique_ptr<IndexScanState> search;
+	//! The outer row of each query of the search
+	vector<idx_t> query_rows;
+
+	//! The (query, row id) pairs requested from the table, and the outer row of each
+	DataChunk matches;
+	SelectionVector request_sel;
+	SelectionVector result_sel;
+	DataChunk fetched;
+	ColumnFetchState fetch_state;
+
+	//! The rows this transaction appended to the table, read when the operator starts
+	bool local_loaded = false;
+	vector<unique_ptr<DataChunk>> local_chunks;
+	//! The outer row and the chunk of appended rows paired next
+	idx_t local_row = 0;
+	idx_t local_chunk = 0;
+};
+
+unique_ptr<OperatorState> PhysicalRTreeIndexJoin::GetOperatorState(ExecutionContext &context) const {
+	return make_uniq<RTreeIndexJoinState>(context.client, *this);
+}
+
+//! Read the rows this transaction appended to the table, which reach the index only when it commits. A plan
+//! built before the appends runs into them as well, so they are looked up when the operator executes.
+static void LoadLocalRows(ClientContext &context, const PhysicalRTreeIndexJoin &op, RTreeIndexJoinState &state) {
+	state.local_loaded = true;
+	auto &local_storage = LocalStorage::Get(context, op.table.catalog);
+	if (local_storage.AddedRows(op.table.GetStorage()) == 0) {
+		return;
+	}
+	TableScanState scan_state;
+	scan_state.Initialize(op.storage_ids, context);
+	local_storage.InitializeScan(op.table.GetStorage(), scan_state.local_state, nullptr);
+	while (true) {
+		auto chunk = make_uniq<DataChunk>();
+		chunk->Initialize(Allocator::Get(context), op.fetch_types);
+		local_storage.Scan(scan_state.local_state, op.storage_ids, *chunk);
+		if (chunk->size() == 0) {
+			return;
+		}
+		state.local_chunks.push_back(std::move(chunk));
+	}
+}
+
+//! Pair the next outer row with the next chunk of appended rows, the join condition above decides.
+//! Returns false once every outer row of the input has been paired with all of them.
+static bool PairLocalRows(DataChunk &input, DataChunk &chunk, RTreeIndexJoinState &state) {
+	if (state.local_chunks.empty() || state.local_row >= input.size()) {
+		return false;
+	}
+	auto &local = *state.local_chunks[state.local_chunk];
+	for (idx_t i = 0; i < local.size(); i++) {
+		state.result_sel.set_index(i, state.local_row);
+	}
+	const auto outer_count = input.ColumnCount();
+	for (idx_t col_idx = 0; col_idx < outer_count; col_idx++) {
+		chunk.data[col_idx].Slice(input.data[col_idx], state.result_sel, local.size());
+	}
+	for (idx_t col_idx = 0; col_idx + 1 < local.ColumnCount(); col_idx++) {
+		chunk.data[outer_count + col_idx].Reference(local.data[col_idx]);
+	}
+	chunk.SetCardinality(local.size());
+	if (++state.local_chunk == state.local_chunks.size()) {
+		state.local_chunk = 0;
+		state.local_row++;
+	}
+	return true;
+}
+
+OperatorResultType PhysicalRTreeIndexJoin::Execute(ExecutionContext &context, DataChunk &input, DataChunk &chunk,
+                                                   GlobalOperatorState &gstate, OperatorState &state_p) const {
+	auto &state = state_p.Cast<RTreeIndexJoinState>();
+
+	if (!state.local_loaded) {
+		LoadLocalRows(context.client, *this, state);
+	}
+	if (!state.search) {
+		state.probe_boxes.Reset();
+		state.executor.Execute(input, state.probe_boxes);
+		UnifiedVectorFormat probe_format;
+		state.probe_boxes.data[0].ToUnifiedFormat(input.size(), probe_format);
+		const auto probe_data = UnifiedVectorFormat::GetData<string_t>(probe_format);
+
+		// All probes of the chunk share one traversal of the tree
+		const auto space = index.GetSpace();
+		vector<RTreeBounds> queries;
+		state.query_rows.clear();
+		for (idx_t i = 0; i < input.size(); i++) {
+			const auto probe_idx = probe_format.sel->get_index(i);
+			if (!probe_format.validity.RowIsValid(probe_idx) || probe_data[probe_idx].GetSize() < sizeof(STBox)) {
+				continue;
+			}
+			STBox probe_box;
+			memcpy(&probe_box, probe_data[probe_idx].GetData(), sizeof(STBox));
+			// Raise the error the join condition would have raised
+			if (!space.IsCompatible(probe_box)) {
+				throw InvalidInputException("Operation on mixed SRID");
+			}
+			queries.push_back(RTreeBounds::FromSTBox(probe_box));
+			state.query_rows.push_back(i);
+		}
+		state.search = index.InitializeBatchScan(std::move(queries));
+		state.local_row = 0;
+		state.local_chunk = 0;
+	}
+
+	// Collect up to a vector of (outer row, row id) pairs
+	state.matches.Reset();
+	const auto request_count = index.BatchScan(*state.search, state.matches);
+	if (request_count == 0) {
+		if (PairLocalRows(input, chunk, state)) {
+			return OperatorResultType::HAVE_MORE_OUTPUT;
+		}
+		state.search.reset();
+		chunk.SetCardinality(0);
+		return OperatorResultType::NEED_MORE_INPUT;
+	}
+	const auto query_ids = FlatVector::GetData<uint32_t>(state.matches.data[0]);
+	for (idx_t i = 0; i < request_count; i++) {
+		state.request_sel.set_index(i, state.query_rows[query_ids[i]]);
+	}
+	auto &row_ids = state.matches.data[1];
+	const auto row_id_data = FlatVector::GetData<row_t>(row_ids);
+
+	auto &transaction = DuckTransaction::Get(context.client, table.catalog);
+	state.fetched.Reset();
+	table.GetStorage().Fetch(transaction, state.fetched, storage_ids, row_ids, request_count, state.fetch_state);
+
+	// The fetch skips rows this transaction cannot see, the trailing row id column lines the rest up with the requests
+	const auto fetched_row_ids = FlatVector::GetData<row_t>(state.fetched.data.back());
+	idx_t request_idx = 0;
+	for (idx_t i = 0; i < state.fetched.size(); i++) {
+		while (row_id_data[request_idx] != fetched_row_ids[i]) {
+			request_idx++;
+		}
+		state.result_sel.set_index(i, state.request_sel.get_index(request_idx++));
+	}
+
+	const auto outer_count = input.ColumnCount();
+	for (idx_t col_idx = 0; col_idx < outer_count; col_idx++) {
+		chunk.data[col_idx].Slice(input.data[col_idx], state.result_sel, state.fetched.size());
+	}
+	for (idx_t col_idx = 0; col_idx + 1 < state.fetched.ColumnCount(); col_idx++) {
+		chunk.data[outer_count + col_idx].Reference(state.fetched.data[col_idx]);
+	}
+	chunk.SetCardinality(state.fetched.size());
+	return OperatorResultType::HAVE_MORE_OUTPUT;
+}
+
+//-------------------------------------------------------------
+// Optimizer
+//-------------------------------------------------------------
+class RTreeIndexJoinOptimizer : public OptimizerExtension {
+public:
+	RTreeIndexJoinOptimizer() {
+		optimize_function = Optimize;
+	}
+
+private:
+	//! Whether the expression can be evaluated from the given columns alone
+	static bool ReferencesOnly(const Expression &expr, const column_binding_set_t &bindings) {
+		if (expr.type == ExpressionType::BOUND_COLUMN_REF) {
+			return bindings.find(expr.Cast<BoundColumnRefExpression>().binding) != bindings.end();
+		}
+		if (expr.IsVolatile() || expr.GetExpressionClass() == ExpressionClass::BOUND_SUBQUERY) {
+			return false;
+		}
+		bool result = true;
+		ExpressionIterator::EnumerateChildren(expr, [&](const Expression &child) {
+			result = result && ReferencesOnly(child, bindings);
+		});
+		return result;
+	}
+
+	//! Rewrite an inner ANY JOIN on `col && probe`, where col or its box carries a TRTREE index and probe only
+	//! depends on the other side, into an index join. The join condition is kept as a filter on top.
+	static bool TryOptimizeJoin(ClientContext &context, unique_ptr<LogicalOperator> &plan) {
+		auto &join = plan->Cast<LogicalAnyJoin>();
+		if (join.join_type != JoinType::INNER) {
+			return false;
+		}
+
+		vector<reference<unique_ptr<Expression>>> terms;
+		if (join.condition->GetExpressionType() == ExpressionType::CONJUNCTION_AND) {
+			for (auto &child : join.condition->Cast<BoundConjunctionExpression>().children) {
+				terms.push_back(child);
+			}
+		} else {
+			terms.push_back(join.condition);
+		}
+
+		for (idx_t inner_idx = 0; inner_idx < 2; inner_idx++) {
+			auto &inner = join.children[inner_idx];
+			auto &outer = join.children[1 - inner_idx];
+			if (inner->type != LogicalOperatorType::LOGICAL_GET) {
+				continue;
+			}
+			auto &get = inner->Cast<LogicalGet>();
+			if (get.function.name != "seq_scan" || !get.GetTable() || !get.GetTable()->IsDuckTable()) {
+				continue;
+			}
+			// Pushed-down filters and pruned filter columns would be lost with the scan
+			if (!get.table_filters.filters.empty() || !get.projection_ids.empty()) {
+				continue;
+			}
+
+			auto &duck_table = get.GetTable()->Cast<DuckTableEntry>();
+
+			column_binding_set_t outer_bindings;
+			for (auto &binding : outer->GetColumnBindings()) {
+				outer_bindings.insert(binding);
+			}
+
+			auto &table_info = *get.GetTable()->GetStorage().GetDataTableInfo();
+
+			unique_ptr<Expression> probe;
+			optional_ptr<RTreeIndex> probe_index;
+
+			table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, [&](RTreeIndex &rtree_index) -> bool {
+				unique_ptr<Expression> index_expr;
+				if (!rtree_index.TryBindIndexExpression(get, index_expr)) {
+					return false;
+				}
+				for (auto &term : terms) {
+					// The operator probes with the overlap search, so only box overlap with an STBOX probe qualifies
+					RTreeIndexPredicate predicate;
+					if (!RTreeIndex::TryMatchPredicate(*term.get(), *index_expr, predicate, false)) {
+						continue;
+					}
+					if (predicate.predicate != RTreePredicate::OVERLAPS ||
+					    (rtree_index.IsMultiEntry() && !predicate.fragment_safe) ||
+					    predicate.query->return_type != StboxType::STBOX() ||
+					    !ReferencesOnly(*predicate.query, outer_bindings)) {
+						continue;
+					}
+					probe = predicate.query->Copy();
+					probe_index = &rtree_index;
+					return true;
+				}
+				return false;
+			});
+
+			if (!probe) {
+				continue;
+			}
+
+			get.ResolveOperatorTypes();
+			auto index_join = make_uniq<LogicalRTreeIndexJoin>(duck_table, *probe_index, get.GetColumnIds(),
+			                                                   get.GetColumnBindings(), get.types, std::move(probe));
+			index_join->children.push_back(std::move(outer));
+			index_join->has_estimated_cardinality = join.has_estimated_cardinality;
+			index_join->estimated_cardinality = join.estimated_cardinality;
+
+			// The index only proves that the boxes overlap, the join condition decides
+			auto filter = make_uniq<LogicalFilter>(std::move(join.condition));
+			filter->children.push_back(std::move(index_join));
+			filter->has_estimated_cardinality = join.has_estimated_cardinality;
+			filter->estimated_cardinality = join.estimated_cardinality;
+			plan = std::move(filter);
+			return true;
+		}
+		return false;
+	}
+
+public:
+	static void OptimizeRecursive(ClientContext &context, unique_ptr<LogicalOperator> &plan) {
+		if (plan->type == LogicalOperatorType::LOGICAL_ANY_JOIN) {
+			TryOptimizeJoin(context, plan);
+		}
+		for (auto &child : plan->children) {
+			OptimizeRecursive(context, child);
+		}
+	}
+
+	static void Optimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+		OptimizeRecursive(input.context, plan);
+	}
+};
+
+void RTreeModule::RegisterIndexJoinOptimizer(DatabaseInstance &instance) {
+	instance.config.optimizer_extensions.push_back(RTreeIndexJoinOptimizer());
+}
+
+} // namespace duckdb
@@ -1,6 +1,7 @@
 #include "duckdb/catalog/catalog_entry/duck_table_entry.hpp"
 #include "duckdb/catalog/dependency_list.hpp"
 #include "duckdb/common/mutex.hpp"
+#include "duckdb/common/string_util.hpp"
 #include "duckdb/function/function_set.hpp"
 #include "duckdb/optimizer/matcher/expression_matcher.hpp"
 #include "duckdb/planner/expression_iterator.hpp"
@@ -8,13 +9,20 @@
 #include "duckdb/storage/table/scan_state.hpp"
 #include "duckdb/transaction/duck_transaction.hpp"
 #include "duckdb/transaction/local_storage.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/main/extension_util.hpp"
 #include "duckdb/catalog/catalog_entry/duck_index_entry.hpp"
 #include "duckdb/storage/data_table.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/table_filter.hpp"
 
 #include "index/rtree_module.hpp"
 #include "index/rtree_index_scan.hpp"
 
+#include <algorithm>
+
 namespace duckdb {
 
 BindInfo RTreeIndexScanBindInfo(const optional_ptr<FunctionData> bind_data_p) {
@@ -26,14 +34,34 @@ BindInfo RTreeIndexScanBindInfo(const optional_ptr<FunctionData> bind_data_p) {
 // Global State
 //-------------------------------------------------------------------------
 struct RTreeIndexScanGlobalState : public GlobalTableFunctionState {
-	DataChunk all_columns;
 	vector<idx_t> projection_ids;
-	ColumnFetchState fetch_state;
 	TableScanState local_storage_state;
 	vector<StorageIndex> column_ids;
+	//! Types of the fetched columns, before columns only needed by filters are projected away
+	vector<LogicalType> scanned_types;
+
+	//! The scanned column that is not fetched, it is emitted as constant NULL
+	optional_idx unread_column;
+	//! The columns actually fetched when one is skipped. Only the row id when no table column is left,
+	//! the fetch then just drops the rows this transaction cannot see.
+	vector<StorageIndex> fetch_ids;
+	vector<LogicalType> fetch_types;
+
+	//! The pushed-down table filters over the scanned columns, evaluated on the fetched rows
+	unique_ptr<Expression> filter;
 
+	//! The index cursor is shared, every thread pulls its own batches of row ids from it. The lock also
+	//! serializes the scan of the rows this transaction appended, which follows the index.
+	mutex index_lock;
 	unique_ptr<IndexScanState> index_state;
-	Vector row_ids = Vector(LogicalType::ROW_TYPE);
+	idx_t max_threads = 1;
+	//! Rows a nearest neighbour scan has produced. Row ids of rows this transaction cannot see are dropped by
+	//! the fetch, the cursor is read until limit rows were produced.
+	idx_t nearest_count = 0;
+
+	idx_t MaxThreads() const override {
+		return max_threads;
+	}
 };
 
 static unique_ptr<GlobalTableFunctionState> RTreeIndexScanInitGlobal(ClientContext &context,
@@ -50,65 +78,286 @@ static unique_ptr<GlobalTableFunctionState> RTreeIndexScanInitGlobal(ClientConte
 		storage_t col_id = id;
 		if (id != DConstants::INVALID_INDEX) {
 			col_id = bind_data.table.GetColumn(LogicalIndex(id)).StorageOid();
+			result->scanned_types.push_back(bind_data.table.GetColumn(LogicalIndex(id)).GetType());
+		} else {
+			result->scanned_types.push_back(LogicalType::ROW_TYPE);
 		}
 		result->column_ids.emplace_back(col_id);
 	}
+	result->projection_ids = input.projection_ids;
+
+	if (!bind_data.read_filter_column) {
+		result->unread_column = bind_data.filter_column;
+		for (idx_t i = 0; i < result->column_ids.size(); i++) {
+			if (i != bind_data.filter_column) {
+				result->fetch_ids.push_back(result->column_ids[i]);
+				result->fetch_types.push_back(result->scanned_types[i]);
+			}
+		}
+		if (result->fetch_ids.empty()) {
+			result->fetch_ids.emplace_back(COLUMN_IDENTIFIER_ROW_ID);
+			result->fetch_types.push_back(LogicalType::ROW_TYPE);
+		}
+	}
+
+	if (input.filters) {
+		// Filters on other columns come first, the recheck of a lossy box test is the most expensive
+		vector<unique_ptr<Expression>> conjuncts;
+		unique_ptr<Expression> recheck;
+		for (auto &entry : input.filters->filters) {
+			BoundReferenceExpression column(result->scanned_types[entry.first], entry.first);
+			if (entry.first != bind_data.filter_column || bind_data.nearest) {
+				conjuncts.push_back(entry.second->ToExpression(column));
+			} else if (!bind_data.exact) {
+				recheck = entry.second->ToExpression(column);
+			}
+		}
+		if (recheck) {
+			conjuncts.push_back(std::move(recheck));
+		}
+		for (auto &conjunct : conjuncts) {
+			if (!result->filter) {
+				result->filter = std::move(conjunct);
+				continue;
+			}
+			result->filter = make_uniq<BoundConjunctionExpression>(ExpressionType::CONJUNCTION_AND,
+			                                                       std::move(result->filter), std::move(conjunct));
+		}
+	}
 
 	// Initialize the storage scan state
 	result->local_storage_state.Initialize(result->column_ids, context, input.filters);
 	local_storage.InitializeScan(bind_data.table.GetStorage(), result->local_storage_state.local_state, input.filters);
 
 
-	if (bind_data.query_stbox) {
-        result->index_state = bind_data.index.Cast<RTreeIndex>().InitializeScan(bind_data.query_stbox.get(), sizeof(STBox));
-    }
+	if (bind_data.query && bind_data.nearest) {
+		// Only limit rows are produced, a second thread would have nothing to fetch
+		result->index_state = bind_data.index.Cast<RTreeIndex>().InitializeNearestScan(*bind_data.query);
+		return std::move(result);
+	}
+	if (bind_data.query) {
+		result->index_state = bind_data.index.Cast<RTreeIndex>().InitializeScan(*bind_data.query, bind_data.predicate);
+	}
+	result->max_threads = bind_data.max_threads;
+	return std::move(result);
+}
+
+//-------------------------------------------------------------------------
+// Local State
+//-------------------------------------------------------------------------
+//! Number of row ids pulled from the cursor at once. They are sorted before fetching, so that
+//! each row group is visited once per window rather than once per tree leaf.
+static constexpr idx_t FETCH_WINDOW_SIZE = 16 * STANDARD_VECTOR_SIZE;
+
+struct RTreeIndexScanLocalState : public LocalTableFunctionState {
+	DataChunk all_columns;
+	//! The fetched columns, when the scan skips one
+	DataChunk fetched_columns;
+	ColumnFetchState fetch_state;
+	Vector row_ids = Vector(LogicalType::ROW_TYPE);
+
+	//! Row ids of the current window in storage order
+	vector<row_t> window;
+	idx_t window_offset = 0;
+	idx_t window_count = 0;
+
+	//! Evaluates the table filters on the fetched rows
+	unique_ptr<ExpressionExecutor> filter_executor;
+	SelectionVector filter_sel;
+};
+
+static unique_ptr<LocalTableFunctionState> RTreeIndexScanInitLocal(ExecutionContext &context,
+                                                                  TableFunctionInitInput &input,
+                                                                  GlobalTableFunctionState *global_state) {
+	auto &bind_data = input.bind_data->Cast<RTreeIndexScanBindData>();
+	auto &gstate = global_state->Cast<RTreeIndexScanGlobalState>();
+
+	auto result = make_uniq<RTreeIndexScanLocalState>();
+	result->window.resize(FETCH_WINDOW_SIZE);
+	if (!gstate.projection_ids.empty()) {
+		result->all_columns.Initialize(context.client, gstate.scanned_types);
+	}
+	if (gstate.unread_column.IsValid()) {
+		result->fetched_columns.Initialize(context.client, gstate.fetch_types);
+	}
+	if (gstate.filter) {
+		result->filter_executor = make_uniq<ExpressionExecutor>(context.client, *gstate.filter);
+		result->filter_sel.Initialize(STANDARD_VECTOR_SIZE);
+	}
 	return std::move(result);
 }
 
 //-------------------------------------------------------------------------
 // Execute
 //-------------------------------------------------------------------------
+//! Fetch the rows of the row ids of the local state into the chunk of the scanned columns
+static void FetchRows(const RTreeIndexScanBindData &bind_data, RTreeIndexScanGlobalState &state,
+                      RTreeIndexScanLocalState &lstate, DuckTransaction &transaction, idx_t row_count,
+                      DataChunk &fetched) {
+	if (!state.unread_column.IsValid()) {
+		bind_data.table.GetStorage().Fetch(transaction, fetched, state.column_ids, lstate.row_ids, row_count,
+		                                   lstate.fetch_state);
+		return;
+	}
+	// Line the fetched columns up with the scanned ones, the skipped column is read by nobody
+	lstate.fetched_columns.Reset();
+	bind_data.table.GetStorage().Fetch(transaction, lstate.fetched_columns, state.fetch_ids, lstate.row_ids,
+	                                   row_count, lstate.fetch_state);
+	idx_t fetched_idx = 0;
+	for (idx_t i = 0; i < state.column_ids.size(); i++) {
+		if (i == state.unread_column.GetIndex()) {
+			fetched.data[i].Reference(Value(state.scanned_types[i]));
+		} else {
+			fetched.data[i].Reference(lstate.fetched_columns.data[fetched_idx++]);
+		}
+	}
+	fetched.SetCardinality(lstate.fetched_columns.size());
+}
+
 static void RTreeIndexScanExecute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
 
 	auto &bind_data = data_p.bind_data->Cast<RTreeIndexScanBindData>();
 
 	auto &state = data_p.global_state->Cast<RTreeIndexScanGlobalState>();
+	auto &lstate = data_p.local_state->Cast<RTreeIndexScanLocalState>();
 
 	auto &transaction = DuckTransaction::Get(context, bind_data.table.catalog);
 
-	auto row_count = bind_data.index.Cast<RTreeIndex>().Scan(*state.index_state, state.row_ids);
-
-	if (row_count == 0) {
+	if (!state.index_state) {
 		output.SetCardinality(0);
 		return;
 	}
-	if (state.projection_ids.empty()) {
-		bind_data.table.GetStorage().Fetch(transaction, output, state.column_ids, state.row_ids, row_count,
-		                                   state.fetch_state);
+
+	// A batch whose rows all fail the filters must not end the scan, so continue until rows remain
+	while (true) {
+		if (lstate.window_offset == lstate.window_count) {
+			// Only advancing the cursor is serialized, the sort and the fetch run in parallel
+			{
+				lock_guard<mutex> guard(state.index_lock);
+				auto request = lstate.window.size();
+				if (bind_data.nearest) {
+					request = MinValue(request, bind_data.limit - state.nearest_count);
+				}
+				lstate.window_count = request == 0 ? 0
+				                                   : bind_data.index.Cast<RTreeIndex>().Scan(
+				                                         *state.index_state, lstate.window.data(), request);
+			}
+			lstate.window_offset = 0;
+			// Row ids are assigned in storage order, so sorting groups them by row group and segment.
+			// A nearest neighbour scan loses its distance order here, the TOP N above it re-sorts its k rows.
+			std::sort(lstate.window.begin(), lstate.window.begin() + NumericCast<int64_t>(lstate.window_count));
+		}
+
+		const auto row_count = MinValue<idx_t>(lstate.window_count - lstate.window_offset, STANDARD_VECTOR_SIZE);
+		auto &fetched = state.projection_ids.empty() ? output : lstate.all_columns;
+		fetched.Reset();
+		if (row_count == 0) {
+			// Rows appended by this transaction are not in the index before it commits. The local storage scan
+			// applies the table filters, including the one the index answers for the committed rows.
+			{
+				lock_guard<mutex> guard(state.index_lock);
+				auto &local_storage = LocalStorage::Get(context, bind_data.table.catalog);
+				local_storage.Scan(state.local_storage_state.local_state, state.column_ids, fetched);
+			}
+			if (fetched.size() == 0) {
+				output.SetCardinality(0);
+				return;
+			}
+		} else {
+			memcpy(FlatVector::GetData<row_t>(lstate.row_ids), lstate.window.data() + lstate.window_offset,
+			       row_count * sizeof(row_t));
+			lstate.window_offset += row_count;
+			FetchRows(bind_data, state, lstate, transaction, row_count, fetched);
+			if (bind_data.nearest) {
+				// A nearest neighbour scan runs on one thread and has no filter on the fetched rows
+				state.nearest_count += fetched.size();
+			}
+		}
+
+		if (lstate.filter_executor) {
+			const auto match_count = lstate.filter_executor->SelectExpression(fetched, lstate.filter_sel);
+			if (match_count < fetched.size()) {
+				fetched.Slice(lstate.filter_sel, match_count);
+			}
+		}
+		if (fetched.size() == 0) {
+			continue;
+		}
+
+		if (!state.projection_ids.empty()) {
+			output.ReferenceColumns(lstate.all_columns, state.projection_ids);
+		}
 		return;
 	}
+}
 
-	state.all_columns.Reset();
-
-	bind_data.table.GetStorage().Fetch(transaction, state.all_columns, state.column_ids, state.row_ids, row_count,
-	                                   state.fetch_state);
 
-	output.ReferenceColumns(state.all_columns, state.projection_ids);
+//-------------------------------------------------------------------------
+// Cardinality
+//-------------------------------------------------------------------------
+static unique_ptr<NodeStatistics> RTreeIndexScanCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<RTreeIndexScanBindData>();
+	return make_uniq<NodeStatistics>(bind_data.estimated_cardinality);
+}
 
+//-------------------------------------------------------------------------
+// To String
+//-------------------------------------------------------------------------
+static InsertionOrderPreservingMap<string> RTreeIndexScanToString(TableFunctionToStringInput &input) {
+	InsertionOrderPreservingMap<string> result;
+	auto &bind_data = input.bind_data->Cast<RTreeIndexScanBindData>();
+	result["Table"] = bind_data.table.name;
+	result["Index"] = bind_data.index.name;
+	if (bind_data.nearest) {
+		result["Search"] = StringUtil::Format("%d nearest", bind_data.limit);
+		return result;
+	}
+	switch (bind_data.predicate) {
+	case RTreePredicate::CONTAINS:
+		result["Search"] = "@>";
+		break;
+	case RTreePredicate::CONTAINED_BY:
+		result["Search"] = "<@";
+		break;
+	default:
+		result["Search"] = "&&";
+		break;
+	}
+	if (!bind_data.exact) {
+		result["Recheck"] = "true";
+	}
+	if (!bind_data.read_filter_column) {
+		result["Fetch"] = "skips the indexed column";
+	}
+	result["Threads"] = to_string(bind_data.max_threads);
+	result["Selectivity"] = StringUtil::Format("%.2f%% estimated, sequential scan above %.2f%%",
+	                                           100 * bind_data.selectivity, 100 * bind_data.max_selectivity);
+	return result;
 }
 
+InsertionOrderPreservingMap<string> RTreeKeptScanBindData::ToString(TableFunctionToStringInput &input) {
+	auto &bind_data = input.bind_data->Cast<RTreeKeptScanBindData>();
+	auto result = bind_data.scan_to_string ? bind_data.scan_to_string(input) : InsertionOrderPreservingMap<string>();
+	result["Skipped Index"] = bind_data.index_name;
+	result["Selectivity"] = StringUtil::Format("%.2f%% estimated, index scan up to %.2f%%",
+	                                           100 * bind_data.selectivity, 100 * bind_data.max_selectivity);
+	return result;
+}
 
 //-------------------------------------------------------------------------
 // Get Function
 //-------------------------------------------------------------------------
 TableFunction RTreeIndexScanFunction::GetFunction() {
-	TableFunction func("mobility rtree index", {}, RTreeIndexScanExecute);
+	TableFunction func(NAME, {}, RTreeIndexScanExecute);
 	func.init_global = RTreeIndexScanInitGlobal;
+	func.init_local = RTreeIndexScanInitLocal;
     
     func.get_bind_info = RTreeIndexScanBindInfo;
+	func.cardinality = RTreeIndexScanCardinality;
+	func.to_string = RTreeIndexScanToString;
     
     func.projection_pushdown = true;
-    func.filter_pushdown = false; 
+    func.filter_pushdown = true;
 	return func;
 }
 
@@ -117,6 +366,11 @@ TableFunction RTreeIndexScanFunction::GetFunction() {
 // -------------------------------------------------------------------------
 void RTreeModule::RegisterIndexScan(DatabaseInstance &db) {
 	ExtensionUtil::RegisterFunction(db, RTreeIndexScanFunction::GetFunction());
+
+	db.config.AddExtensionOption(RTreeIndexScanFunction::MAX_SELECTIVITY_SETTING,
+	                             "Estimated fraction of the rows of a table above which a filter on a TRTREE indexed "
+	                             "column is answered by a sequential scan instead of the index",
+	                             LogicalType::DOUBLE, Value::DOUBLE(RTreeIndexScanFunction::DEFAULT_MAX_SELECTIVITY));
 }
 
 } 
\ No newline at end of file
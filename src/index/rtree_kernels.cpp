@@ -0,0 +1,132 @@
+#include "meos_wrapper_simple.hpp"
+
+#include "index/rtree.hpp"
+
+// The vector kernels are compiled for their instruction set with a function attribute and picked at runtime,
+// the rest of the extension keeps the baseline target of the build
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__)
+#define MOBILITYDUCK_RTREE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define MOBILITYDUCK_RTREE_X86_KERNELS 0
+#endif
+
+namespace duckdb {
+
+//------------------------------------------------------------------------------
+// Intersection kernels
+//------------------------------------------------------------------------------
+// Every kernel returns the bitmask of the first node.count entries whose bounds intersect the query, that is
+// RTreeBounds::Intersects for each entry. The vector kernels test full groups of entries and leave the
+// remainder to the scalar loop, so that no slot past the count is read.
+typedef uint64_t (*rtree_intersect_kernel_t)(const RTreeNode &node, const RTreeBounds &query);
+
+static uint64_t IntersectingFrom(const RTreeNode &node, const RTreeBounds &query, idx_t begin) {
+    uint64_t result = 0;
+    for (idx_t i = begin; i < node.count; i++) {
+        const bool hit = (node.xmin[i] <= query.xmax) & (query.xmin <= node.xmax[i]) & (node.ymin[i] <= query.ymax) &
+                         (query.ymin <= node.ymax[i]) & (node.zmin[i] <= query.zmax) & (query.zmin <= node.zmax[i]) &
+                         (node.tmin[i] <= query.tmax) & (query.tmin <= node.tmax[i]);
+        result |= static_cast<uint64_t>(hit) << i;
+    }
+    return result;
+}
+
+static uint64_t IntersectingScalar(const RTreeNode &node, const RTreeBounds &query) {
+    return IntersectingFrom(node, query, 0);
+}
+
+#if MOBILITYDUCK_RTREE_X86_KERNELS
+__attribute__((target("avx2"))) static uint64_t IntersectingAVX2(const RTreeNode &node, const RTreeBounds &query) {
+    const auto qxmin = _mm256_set1_pd(query.xmin);
+    const auto qxmax = _mm256_set1_pd(query.xmax);
+    const auto qymin = _mm256_set1_pd(query.ymin);
+    const auto qymax = _mm256_set1_pd(query.ymax);
+    const auto qzmin = _mm256_set1_pd(query.zmin);
+    const auto qzmax = _mm256_set1_pd(query.zmax);
+    const auto qtmin = _mm256_set1_epi64x(query.tmin);
+    const auto qtmax = _mm256_set1_epi64x(query.tmax);
+
+    static constexpr idx_t WIDTH = 4;
+    uint64_t result = 0;
+    idx_t i = 0;
+    for (; i + WIDTH <= node.count; i += WIDTH) {
+        auto hit = _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(node.xmin + i), qxmax, _CMP_LE_OQ),
+                                 _mm256_cmp_pd(qxmin, _mm256_loadu_pd(node.xmax + i), _CMP_LE_OQ));
+        hit = _mm256_and_pd(hit, _mm256_cmp_pd(_mm256_loadu_pd(node.ymin + i), qymax, _CMP_LE_OQ));
+        hit = _mm256_and_pd(hit, _mm256_cmp_pd(qymin, _mm256_loadu_pd(node.ymax + i), _CMP_LE_OQ));
+        hit = _mm256_and_pd(hit, _mm256_cmp_pd(_mm256_loadu_pd(node.zmin + i), qzmax, _CMP_LE_OQ));
+        hit = _mm256_and_pd(hit, _mm256_cmp_pd(qzmin, _mm256_loadu_pd(node.zmax + i), _CMP_LE_OQ));
+        // AVX2 only has a signed greater-than for 64-bit integers, a time miss is tmin > qtmax or qtmin > tmax
+        const auto tmin = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(node.tmin + i));
+        const auto tmax = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(node.tmax + i));
+        const auto miss = _mm256_or_si256(_mm256_cmpgt_epi64(tmin, qtmax), _mm256_cmpgt_epi64(qtmin, tmax));
+        const auto bits = _mm256_movemask_pd(_mm256_andnot_pd(_mm256_castsi256_pd(miss), hit));
+        result |= static_cast<uint64_t>(bits) << i;
+    }
+    return result | IntersectingFrom(node, query, i);
+}
+
+__attribute__((target("avx512f"))) static uint64_t IntersectingAVX512(const RTreeNode &node,
+                                                                      const RTreeBounds &query) {
+    const auto qxmin = _mm512_set1_pd(query.xmin);
+    const auto qxmax = _mm512_set1_pd(query.xmax);
+    const auto qymin = _mm512_set1_pd(query.ymin);
+    const auto qymax = _mm512_set1_pd(query.ymax);
+    const auto qzmin = _mm512_set1_pd(query.zmin);
+    const auto qzmax = _mm512_set1_pd(query.zmax);
+    const auto qtmin = _mm512_set1_epi64(query.tmin);
+    const auto qtmax = _mm512_set1_epi64(query.tmax);
+
+    static constexpr idx_t WIDTH = 8;
+    uint64_t result = 0;
+    idx_t i = 0;
+    for (; i + WIDTH <= node.count; i += WIDTH) {
+        // Each comparison only tests the lanes that still hit
+        auto hit = _mm512_cmp_pd_mask(_mm512_loadu_pd(node.xmin + i), qxmax, _CMP_LE_OQ);
+        hit = _mm512_mask_cmp_pd_mask(hit, qxmin, _mm512_loadu_pd(node.xmax + i), _CMP_LE_OQ);
+        hit = _mm512_mask_cmp_pd_mask(hit, _mm512_loadu_pd(node.ymin + i), qymax, _CMP_LE_OQ);
+        hit = _mm512_mask_cmp_pd_mask(hit, qymin, _mm512_loadu_pd(node.ymax + i), _CMP_LE_OQ);
+        hit = _mm512_mask_cmp_pd_mask(hit, _mm512_loadu_pd(node.zmin + i), qzmax, _CMP_LE_OQ);
+        hit = _mm512_mask_cmp_pd_mask(hit, qzmin, _mm512_loadu_pd(node.zmax + i), _CMP_LE_OQ);
+        hit = _mm512_mask_cmple_epi64_mask(hit, _mm512_loadu_si512(node.tmin + i), qtmax);
+        hit = _mm512_mask_cmple_epi64_mask(hit, qtmin, _mm512_loadu_si512(node.tmax + i));
+        result |= static_cast<uint64_t>(hit) << i;
+    }
+    return result | IntersectingFrom(node, query, i);
+}
+#endif
+
+struct RTreeKernel {
+    rtree_intersect_kernel_t intersecting;
+    const char *name;
+};
+
+static RTreeKernel SelectKernel() {
+#if MOBILITYDUCK_RTREE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return {IntersectingAVX512, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return {IntersectingAVX2, "avx2"};
+    }
+#endif
+    return {IntersectingScalar, "scalar"};
+}
+
+//! The kernel is selected once, on first use
+static const RTreeKernel &GetKernel() {
+    static const RTreeKernel kernel = SelectKernel();
+    return kernel;
+}
+
+uint64_t RTreeNode::Intersecting(const RTreeBounds &query) const {
+    return GetKernel().intersecting(*this, query);
+}
+
+const char *RTreeKernelName() {
+    return GetKernel().name;
+}
+
+} // namespace duckdb
@@ -9,6 +9,9 @@
 #include "duckdb/execution/index/fixed_size_allocator.hpp"
 #include "duckdb/storage/table/scan_state.hpp"
 #include "duckdb/main/database.hpp"
+#include "duckdb/storage/table_io_manager.hpp"
+#include "duckdb/storage/index_storage_info.hpp"
+#include "duckdb/storage/partial_block_manager.hpp"
 
 #include "duckdb/execution/index/bound_index.hpp"
 #include "duckdb/common/exception.hpp"
@@ -19,20 +22,37 @@
 #include "duckdb/planner/operator/logical_create_index.hpp"
 #include "duckdb/planner/expression/bound_reference_expression.hpp"
 #include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_cast_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
 #include "duckdb/parser/parsed_data/create_index_info.hpp"
 #include "duckdb/execution/operator/projection/physical_projection.hpp"
 #include "duckdb/execution/operator/filter/physical_filter.hpp"
 #include "duckdb/common/case_insensitive_map.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/interval.hpp"
 #include "duckdb/optimizer/matcher/expression_matcher.hpp"
 #include "index/rtree_module.hpp"
 #include "geo/stbox.hpp"
+#include "geo/tgeompoint.hpp"
+#include "geo/tgeometry.hpp"
+#include "temporal/span.hpp"
+#include "temporal/tbox.hpp"
+#include "temporal/temporal.hpp"
+#include "time_util.hpp"
 #include "index/rtree_index_create_physical.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 
 namespace duckdb {
 
 //------------------------------------------------------------------------------
-// RTreeIndex Implementation with MEOS RTree Integration
+// RTreeIndex Implementation
 //------------------------------------------------------------------------------
 
 RTreeIndex::RTreeIndex(const string &name, IndexConstraintType constraint_type,
@@ -42,37 +62,87 @@ RTreeIndex::RTreeIndex(const string &name, IndexConstraintType constraint_type,
                        const case_insensitive_map_t<Value> &options,
                        const IndexStorageInfo &info)
     : BoundIndex(name, TYPE_NAME, constraint_type, column_ids, table_io_manager, 
-                unbound_expressions, db), options_(options), rtree_(nullptr) {
-    
+                unbound_expressions, db), options_(options) {
     
-    // Create RTree specifically for integer stboxs (stbox)
-    rtree_ = rtree_create_stbox();
-    if (!rtree_) {
-        throw InternalException("Failed to create MEOS RTree for stbox");
+    split = RTreeSplit::Parse(options_);
+    space = RTreeSpace::Parse(options_);
+    tree = make_uniq<TRTree>(table_io_manager.GetIndexBlockManager());
+    if (info.IsValid()) {
+        // A persisted index: restore the root and the buffer layout, the nodes are read on first access
+        tree->GetRoot().Set(info.root);
+        if (!info.allocator_infos.empty()) {
+            tree->GetAllocator().Init(info.allocator_infos[0]);
+        }
+        // The reference system may have been fixed by boxes appended after CREATE INDEX
+        space.Merge(RTreeSpace::Parse(info.options));
+        auto entry_count = info.options.find(ENTRY_COUNT_OPTION);
+        if (entry_count != info.options.end()) {
+            index_size = entry_count->second.GetValue<idx_t>();
+        } else if (info.root != 0) {
+            index_size = tree->GetStats().entry_count;
+        }
     }
     function_matcher = MakeFunctionMatcher();
+    nearest_matcher = MakeNearestMatcher();
 }
 
 class RTreeIndexScanState final : public IndexScanState {
 public:
-    STBox query_stbox;
-    vector<row_t> search_results;
-    idx_t current_position = 0;
+    //! The traversal position, row ids are produced on demand by Scan
+    RTreeCursor cursor;
     bool initialized = false;
+    RTreeBounds query;
+    RTreePredicate predicate = RTreePredicate::OVERLAPS;
+
+    //! Distance-ordered traversal, used instead of the cursor for nearest neighbour scans
+    RTreeNearestCursor nearest_cursor;
+    bool nearest = false;
+
+    //! Matches among the buffered appends, emitted before those of the tree
+    vector<row_t> delta_rows;
+    idx_t delta_offset = 0;
+
+    //! Row ids emitted so far, when a row can be reached through several fragments
+    bool deduplicate = false;
+    unordered_set<row_t> emitted;
 };
 
-RTreeIndex::~RTreeIndex() {
-    if (rtree_) {
-        rtree_free(rtree_);
-        rtree_ = nullptr;
-    }
+class RTreeIndexBatchScanState final : public IndexScanState {
+public:
+    RTreeBatchCursor cursor;
+
+    //! Matches among the buffered appends, emitted before those of the tree
+    vector<pair<uint32_t, row_t>> delta_pairs;
+    idx_t delta_offset = 0;
 
+    //! Row ids emitted so far for each query, when a row can be reached through several fragments
+    bool deduplicate = false;
+    vector<unordered_set<row_t>> emitted;
+};
+
+RTreeIndex::~RTreeIndex() {
 }
 
 PhysicalOperator &RTreeIndex::CreatePlan(PlanIndexInput &input) {
     auto &create_index = input.op;
     auto &planner = input.planner;
 
+    if (create_index.expressions.size() != 1) {
+        throw BinderException("TRTREE indexes can only be created over a single expression");
+    }
+    auto &key_type = create_index.expressions[0]->return_type;
+    if (key_type != StboxType::STBOX() && key_type != TboxType::TBOX() && !IsTemporalType(key_type)) {
+        throw BinderException(
+            "TRTREE indexes can only be created over STBOX, TGEOMPOINT, TGEOMETRY, TBOX, TINT or TFLOAT, not %s",
+            key_type.ToString());
+    }
+    if (RTreeSplit::Parse(create_index.info->options).IsEnabled() &&
+        (!IsTemporalType(key_type) || IsNumberType(key_type))) {
+        throw BinderException("The split option of TRTREE indexes requires a TGEOMPOINT or TGEOMETRY key");
+    }
+    // Reject a malformed srid before scanning the table
+    RTreeSpace::Parse(create_index.info->options);
+
     vector<LogicalType> new_column_types;
     vector<unique_ptr<Expression>> select_list;
     
@@ -81,9 +151,10 @@ PhysicalOperator &RTreeIndex::CreatePlan(PlanIndexInput &input) {
         select_list.push_back(std::move(expression));
     }
     
-    // new_column_types.emplace_back(LogicalType::ROW_TYPE);
-    // select_list.push_back(
-    //     make_uniq<BoundReferenceExpression>(LogicalType::ROW_TYPE, create_index.info->scan_types.size() - 1));
+    // The sink expects the row id after the indexed expression
+    new_column_types.emplace_back(LogicalType::ROW_TYPE);
+    select_list.push_back(
+        make_uniq<BoundReferenceExpression>(LogicalType::ROW_TYPE, create_index.info->scan_types.size() - 1));
 
     auto &projection = planner.Make<PhysicalProjection>(new_column_types, std::move(select_list), 
                                                        create_index.estimated_cardinality);
@@ -97,79 +168,281 @@ PhysicalOperator &RTreeIndex::CreatePlan(PlanIndexInput &input) {
     
     physical_create_index.children.push_back(projection);
     return physical_create_index;
-    return input.table_scan;
 }
 
 //------------------------------------------------------------------------------
-// Core RTree Operations using MEOS
+// Core RTree Operations
 //------------------------------------------------------------------------------
-ErrorData RTreeIndex::Insert(IndexLock &lock, DataChunk &data, Vector &row_ids) {
-    if (!rtree_) {
-        return ErrorData("RTree not initialized");
+bool RTreeIndex::IsTemporalType(const LogicalType &type) {
+    return type == TgeompointType::TGEOMPOINT() || type == TGeometryTypes::TGEOMETRY() ||
+           type == TemporalTypes::TINT() || type == TemporalTypes::TFLOAT();
+}
+
+bool RTreeIndex::IsNumberType(const LogicalType &type) {
+    return type == TboxType::TBOX() || type == TemporalTypes::TINT() || type == TemporalTypes::TFLOAT();
+}
+
+LogicalType RTreeIndex::GetBoxType(const LogicalType &key_type) {
+    return IsNumberType(key_type) ? TboxType::TBOX() : StboxType::STBOX();
+}
+
+RTreeSplit RTreeSplit::Parse(const case_insensitive_map_t<Value> &options) {
+    RTreeSplit result;
+    auto entry = options.find("split");
+    if (entry == options.end() || entry->second.IsNull()) {
+        return result;
     }
-    
-    if (data.size() == 0 || data.ColumnCount() == 0) {
-        return ErrorData(); 
+    const auto spec = entry->second.ToString();
+    const auto separator = spec.find(':');
+    const auto kind = StringUtil::Lower(StringUtil::Trim(spec.substr(0, separator)));
+    const auto argument = separator == string::npos ? string() : StringUtil::Trim(spec.substr(separator + 1));
+
+    if (kind == "none" && separator == string::npos) {
+        return result;
     }
-    DataChunk expression_result;
-    expression_result.Initialize(Allocator::DefaultAllocator(), logical_types);
-    
-    ExecuteExpressions(data, expression_result);
-    
-    auto &stbox_vector = expression_result.data[0]; 
-    auto row_data = FlatVector::GetData<row_t>(row_ids);
+    if (kind == "segments") {
+        int32_t segments;
+        if (!TryCast::Operation<string_t, int32_t>(string_t(argument), segments, true) || segments < 1) {
+            throw InvalidInputException("TRTREE split '%s' needs a positive number of boxes, e.g. 'segments:32'",
+                                        spec);
+        }
+        result.type = Type::SEGMENTS;
+        result.segments = segments;
+        return result;
+    }
+    if (kind == "time") {
+        interval_t duration;
+        string error;
+        if (!Interval::FromCString(argument.c_str(), argument.size(), duration, &error, true) ||
+            duration.months != 0 || Interval::GetMicro(duration) <= 0) {
+            throw InvalidInputException(
+                "TRTREE split '%s' needs a positive bin width without months, e.g. 'time:1h'", spec);
+        }
+        result.type = Type::TIME;
+        result.duration = duration;
+        return result;
+    }
+    throw InvalidInputException("Unknown TRTREE split '%s', expected 'segments:<count>' or 'time:<interval>'", spec);
+}
 
-    if (stbox_vector.GetVectorType() != VectorType::FLAT_VECTOR) {
-        stbox_vector.Flatten(expression_result.size());
+void RTreeSpace::AddReference(int32_t box_srid, bool box_geodetic) {
+    if (!has_x) {
+        has_x = true;
+        srid = box_srid;
+        geodetic = box_geodetic;
+        return;
     }
-    
-    auto vector_type = stbox_vector.GetType();
-    
-    boxes = (STBox*)malloc(sizeof(STBox) * expression_result.size());
-    
-    for (idx_t i = 0; i < expression_result.size(); i++) {
-        if (FlatVector::IsNull(stbox_vector, i)) {
-            continue; 
-        }
-        
-        STBox *box = nullptr;
-        
-        if (vector_type.id() == LogicalTypeId::BLOB ) {
-            auto blob_data = FlatVector::GetData<string_t>(stbox_vector)[i];
-
-            std::string s = blob_data.GetString();
-            const uint8_t *stbox_data = reinterpret_cast<const uint8_t*>(blob_data.GetData());
-            size_t stbox_size = blob_data.GetSize();
-                        
-            box = (STBox*)malloc(stbox_size);
-            
-            memcpy(box, stbox_data, stbox_size);
-            
-            int32_t box_srid = stbox_srid(box);
-            if (box_srid != 0) {
-                STBox *normalized_box = stbox_set_srid(box, 0);
-                if (normalized_box) {
-                    free(box);
-                    box = normalized_box;
-                }
+    if (box_srid != srid || box_geodetic != geodetic) {
+        throw InvalidInputException("TRTREE index boxes must share one spatial reference system, found %s "
+                                    "SRID %d next to %s SRID %d",
+                                    box_geodetic ? "geodetic" : "planar", box_srid, geodetic ? "geodetic" : "planar",
+                                    srid);
+    }
+}
+
+void RTreeSpace::Add(const STBox &box) {
+    has_t |= MEOS_FLAGS_GET_T(box.flags);
+    if (MEOS_FLAGS_GET_X(box.flags)) {
+        has_z |= MEOS_FLAGS_GET_Z(box.flags);
+        AddReference(box.srid, MEOS_FLAGS_GET_GEODETIC(box.flags));
+    }
+}
+
+void RTreeSpace::Add(const TBox &box) {
+    has_t |= MEOS_FLAGS_GET_T(box.flags);
+}
+
+void RTreeSpace::Merge(const RTreeSpace &other) {
+    has_t |= other.has_t;
+    if (other.has_x) {
+        has_z |= other.has_z;
+        AddReference(other.srid, other.geodetic);
+    }
+}
+
+bool RTreeSpace::IsCompatible(const STBox &query) const {
+    if (!has_x || !MEOS_FLAGS_GET_X(query.flags)) {
+        return true;
+    }
+    return query.srid == srid && bool(MEOS_FLAGS_GET_GEODETIC(query.flags)) == geodetic;
+}
+
+string RTreeSpace::GetDimensions() const {
+    string result = has_x ? "XY" : "";
+    if (has_z) {
+        result += "Z";
+    }
+    if (has_t) {
+        result += "T";
+    }
+    return result;
+}
+
+RTreeSpace RTreeSpace::Parse(const case_insensitive_map_t<Value> &options) {
+    RTreeSpace result;
+    auto entry = options.find("srid");
+    if (entry != options.end() && !entry->second.IsNull()) {
+        Value srid;
+        string error;
+        if (!entry->second.DefaultTryCastAs(LogicalType::INTEGER, srid, &error, true)) {
+            throw InvalidInputException("TRTREE srid '%s' is not an integer", entry->second.ToString());
+        }
+        result.has_x = true;
+        result.srid = IntegerValue::Get(srid);
+    }
+    entry = options.find("geodetic");
+    if (entry != options.end() && !entry->second.IsNull()) {
+        result.geodetic = BooleanValue::Get(entry->second.DefaultCastAs(LogicalType::BOOLEAN));
+    }
+    entry = options.find("dims");
+    if (entry != options.end() && !entry->second.IsNull()) {
+        const auto dims = StringUtil::Upper(entry->second.ToString());
+        result.has_z = dims.find('Z') != string::npos;
+        result.has_t = dims.find('T') != string::npos;
+    }
+    return result;
+}
+
+void RTreeSpace::Serialize(case_insensitive_map_t<Value> &options) const {
+    if (has_x) {
+        options["srid"] = Value::INTEGER(srid);
+        options["geodetic"] = Value::BOOLEAN(geodetic);
+    }
+    options["dims"] = Value(GetDimensions());
+}
+
+//! Append the leaf entries of a serialized temporal value: the box of each fragment when it is split,
+//! otherwise or if it cannot be split its STBOX. Returns false for a malformed value.
+static bool AppendTemporalEntries(const string_t &blob, idx_t row_id, const RTreeSplit &split,
+                                  vector<RTreeEntry> &result, STBox &value_box) {
+    if (blob.GetSize() < sizeof(Temporal)) {
+        return false;
+    }
+    // MEOS expects an aligned value
+    auto temp = reinterpret_cast<Temporal *>(malloc(blob.GetSize()));
+    memcpy(temp, blob.GetData(), blob.GetSize());
+    STBox *box = tspatial_to_stbox(temp);
+    if (!box) {
+        free(temp);
+        return false;
+    }
+    value_box = *box;
+    free(box);
+
+    const auto start = result.size();
+    if (split.type == RTreeSplit::Type::SEGMENTS) {
+        int count = 0;
+        STBox *boxes = tgeo_split_n_stboxes(temp, split.segments, &count);
+        for (int i = 0; i < count; i++) {
+            result.emplace_back(RTreeBounds::FromSTBox(boxes[i]), row_id);
+        }
+        free(boxes);
+    } else if (split.type == RTreeSplit::Type::TIME) {
+        MeosInterval duration = IntervaltToInterval(split.duration);
+        TimestampTz *bins = nullptr;
+        int count = 0;
+        Temporal **fragments = temporal_time_split(temp, &duration, 0, &bins, &count);
+        for (int i = 0; i < count; i++) {
+            STBox *fragment_box = tspatial_to_stbox(fragments[i]);
+            if (fragment_box) {
+                result.emplace_back(RTreeBounds::FromSTBox(*fragment_box), row_id);
+                free(fragment_box);
             }
-        } 
-        else { 
+            free(fragments[i]);
+        }
+        free(fragments);
+        free(bins);
+    }
+    if (result.size() == start) {
+        result.emplace_back(RTreeBounds::FromSTBox(value_box), row_id);
+    }
+    free(temp);
+    return true;
+}
+
+//! Read a TBOX blob, or compute the TBOX of a serialized temporal number. Returns false for a malformed value.
+static bool GetNumberBox(const string_t &blob, bool is_temporal, TBox &result) {
+    if (!is_temporal) {
+        if (blob.GetSize() < sizeof(TBox)) {
+            return false;
+        }
+        // The blob data is not guaranteed to be aligned
+        memcpy(&result, blob.GetData(), sizeof(TBox));
+        return true;
+    }
+    if (blob.GetSize() < sizeof(Temporal)) {
+        return false;
+    }
+    auto temp = reinterpret_cast<Temporal *>(malloc(blob.GetSize()));
+    memcpy(temp, blob.GetData(), blob.GetSize());
+    TBox *box = tnumber_to_tbox(temp);
+    free(temp);
+    if (!box) {
+        return false;
+    }
+    result = *box;
+    free(box);
+    return true;
+}
+
+void RTreeIndex::GetEntries(Vector &box_vector, Vector &row_identifiers, idx_t count, vector<RTreeEntry> &result,
+                            RTreeSpace &space) const {
+    const auto &key_type = box_vector.GetType();
+    const auto is_number = IsNumberType(key_type);
+    const auto is_temporal = IsTemporalType(key_type);
+
+    UnifiedVectorFormat box_format;
+    UnifiedVectorFormat rowid_format;
+    box_vector.ToUnifiedFormat(count, box_format);
+    row_identifiers.ToUnifiedFormat(count, rowid_format);
+
+    const auto box_data = UnifiedVectorFormat::GetData<string_t>(box_format);
+    const auto row_data = UnifiedVectorFormat::GetData<row_t>(rowid_format);
+
+    for (idx_t i = 0; i < count; i++) {
+        const auto box_idx = box_format.sel->get_index(i);
+        const auto row_idx = rowid_format.sel->get_index(i);
+        if (!box_format.validity.RowIsValid(box_idx) || !rowid_format.validity.RowIsValid(row_idx)) {
             continue;
         }
-        
-        if (box == nullptr) {
+        const auto row_id = NumericCast<idx_t>(row_data[row_idx]);
+        auto &blob = box_data[box_idx];
+        if (is_number) {
+            TBox box;
+            if (!GetNumberBox(blob, is_temporal, box)) {
+                continue;
+            }
+            result.emplace_back(RTreeBounds::FromTBox(box), row_id);
+            space.Add(box);
             continue;
         }
-        
-        memcpy(&boxes[i], box, sizeof(STBox));
-        
-        rtree_insert(rtree_, &boxes[i], static_cast<int64_t>(row_data[i]));
-        
-        free(box);
+        STBox box;
+        if (is_temporal) {
+            if (!AppendTemporalEntries(blob, row_id, split, result, box)) {
+                continue;
+            }
+        } else {
+            if (blob.GetSize() < sizeof(STBox)) {
+                continue;
+            }
+            // The blob data is not guaranteed to be aligned
+            memcpy(&box, blob.GetData(), sizeof(STBox));
+            result.emplace_back(RTreeBounds::FromSTBox(box), row_id);
+        }
+        space.Add(box);
     }
+}
+
+ErrorData RTreeIndex::Insert(IndexLock &lock, DataChunk &data, Vector &row_ids) {
+    if (data.size() == 0 || data.ColumnCount() == 0) {
+        return ErrorData(); 
+    }
+    DataChunk expression_result;
+    expression_result.Initialize(Allocator::DefaultAllocator(), logical_types);
+    
+    ExecuteExpressions(data, expression_result);
 
-    free(boxes);
+    Construct(expression_result, row_ids);
     
     return ErrorData();
 }
@@ -187,167 +460,396 @@ ErrorData RTreeIndex::Append(IndexLock &lock, DataChunk &appended_data, Vector &
 }
 
 void RTreeIndex::Construct(DataChunk &expression_result, Vector &row_identifiers) {
-    if (!rtree_) {
-        throw InternalException("RTree not initialized");
-    }
-    
     if (expression_result.size() == 0 || expression_result.ColumnCount() == 0) {
         return; 
     }
     
     auto &stbox_vector = expression_result.data[0];
-    auto row_data = FlatVector::GetData<row_t>(row_identifiers);
+    if (stbox_vector.GetType().id() != LogicalTypeId::BLOB) {
+        return;
+    }
 
-    if (stbox_vector.GetVectorType() != VectorType::FLAT_VECTOR) {
-        stbox_vector.Flatten(expression_result.size());
+    // The boxes are converted without any latch, the reference system check starts from the current space
+    vector<RTreeEntry> entries;
+    auto appended_space = GetSpace();
+    GetEntries(stbox_vector, row_identifiers, expression_result.size(), entries, appended_space);
+    if (entries.empty()) {
+        return;
     }
-    
-    auto vector_type = stbox_vector.GetType();
-    
-    STBox* boxes = (STBox*)malloc(sizeof(STBox) * expression_result.size());
-    
-    for (idx_t i = 0; i < expression_result.size(); i++) {
-        if (FlatVector::IsNull(stbox_vector, i)) {
-            continue; 
-        }
-
-        STBox *box = nullptr;
-        
-        if (vector_type.id() == LogicalTypeId::BLOB ) {
-            auto blob_data = FlatVector::GetData<string_t>(stbox_vector)[i];
-            const uint8_t *stbox_data = reinterpret_cast<const uint8_t*>(blob_data.GetData());
-            size_t stbox_size = blob_data.GetSize();
-                        
-            box = (STBox*)malloc(stbox_size);
-            memcpy(box, stbox_data, stbox_size);
-
-            int32_t box_srid = stbox_srid(box);
-            if (box_srid != 0) {
-                STBox *normalized_box = stbox_set_srid(box, 0);
-                if (normalized_box) {
-                    free(box);
-                    box = normalized_box;
-                }
-            }
-        } 
-        else { 
-            continue;
-        }
 
-        if (box == nullptr) {
-            continue;
-        }
-        
-        memcpy(&boxes[i], box, sizeof(STBox));
-        rtree_insert(rtree_, &boxes[i], static_cast<int64_t>(row_data[i]));
-        free(box);
+    // Small appends are buffered and merged into the tree in bulk. A concurrent append can have fixed
+    // another reference system meanwhile, the merge throws before any entry is buffered.
+    bool full;
+    {
+        lock_guard<mutex> guard(buffer_lock);
+        space.Merge(appended_space);
+        delta.insert(delta.end(), entries.begin(), entries.end());
+        full = delta.size() >= DELTA_CAPACITY;
     }
-    
-    free(boxes);
+    index_size += entries.size();
+    if (!full) {
+        return;
+    }
+    // The append does not wait for scans reading the tree and leaves the entries buffered meanwhile
+    auto tree_lock = rwlock.TryGetExclusiveLock();
+    if (tree_lock) {
+        FlushDelta();
+    }
+}
+
+void RTreeIndex::FlushDelta() {
+    tree->ReleaseRetired();
+    // Scans take their shared key before copying the buffer, none can miss the entries while they move.
+    // Cursors that copied them walk a snapshot of the tree without them.
+    vector<RTreeEntry> entries;
+    {
+        lock_guard<mutex> guard(buffer_lock);
+        entries.swap(delta);
+    }
+    if (entries.empty()) {
+        return;
+    }
+    TRTree delta_tree(table_io_manager.GetIndexBlockManager());
+    delta_tree.BulkLoad(entries);
+    tree->Merge(delta_tree);
+}
+
+unique_ptr<StorageLockKey> RTreeIndex::LockTreeExclusive() {
+    // Scans hold their shared key for one call at a time, and the waiting writer keeps new keys out
+    return rwlock.GetExclusiveLock();
 }
 
 // Use for create physical plan
-// individual insertion for now
-ErrorData RTreeIndex::BulkConstruct(STBox* boxes, const row_t* row_ids, idx_t count) {
-    if (!rtree_) {
-        return ErrorData("RTree not initialized");
+unique_ptr<RTreePartition> RTreeIndex::PackPartition(vector<RTreeEntry> &entries) const {
+    auto partition = make_uniq<RTreePartition>();
+    partition->tree = make_uniq<TRTree>(table_io_manager.GetIndexBlockManager());
+    partition->entry_count = entries.size();
+    if (!entries.empty()) {
+        partition->leaves = partition->tree->PackLevel(entries, 0);
     }
+    entries.clear();
+    return partition;
+}
 
-    for (idx_t i = 0; i < count; i++) {
-        rtree_insert(rtree_, &boxes[i], static_cast<int64_t>(row_ids[i]));
+ErrorData RTreeIndex::MergePartitions(vector<unique_ptr<RTreePartition>> &partitions) {
+    // The index is not visible to other connections before it is built, no latch is needed
+    const auto has_leaves = std::any_of(partitions.begin(), partitions.end(),
+                                        [](const unique_ptr<RTreePartition> &partition) {
+                                            return !partition->leaves.empty();
+                                        });
+    if (!has_leaves) {
+        partitions.clear();
+        return ErrorData();
+    }
+    if (!tree->IsEmpty()) {
+        return ErrorData(ExceptionType::INTERNAL, "Cannot bulk load a non-empty RTree index");
     }
+    // Only partitions that packed nodes hand over their allocator
+    vector<RTreeEntry> leaves;
+    for (auto &partition : partitions) {
+        if (partition->leaves.empty()) {
+            continue;
+        }
+        index_size += partition->entry_count;
+        tree->MergeNodes(*partition->tree, partition->leaves);
+        leaves.insert(leaves.end(), partition->leaves.begin(), partition->leaves.end());
+    }
+    partitions.clear();
 
+    // Repack the leaves of all partitions into one set of upper levels
+    tree->BulkLoad(leaves, 1);
     return ErrorData();
 }
 
-void RTreeIndex::Delete(IndexLock &lock, DataChunk &entries, Vector &row_identifiers) {
+void RTreeIndex::Delete(IndexLock &lock, DataChunk &input, Vector &row_identifiers) {
+    if (input.size() == 0) {
+        return;
+    }
+    DataChunk expression_result;
+    expression_result.Initialize(Allocator::DefaultAllocator(), logical_types);
+    ExecuteExpressions(input, expression_result);
+
+    // The deleted values yield the same boxes they were inserted with
+    vector<RTreeEntry> entries;
+    auto deleted_space = GetSpace();
+    GetEntries(expression_result.data[0], row_identifiers, input.size(), entries, deleted_space);
+    if (entries.empty()) {
+        return;
+    }
 
-    throw NotImplementedException("RTree deletion not implemented - consider rebuilding index");
+    auto tree_lock = LockTreeExclusive();
+    tree->ReleaseRetired();
+    lock_guard<mutex> guard(buffer_lock);
+    idx_t removed = 0;
+    for (auto &entry : entries) {
+        auto buffered = std::find_if(delta.begin(), delta.end(), [&](const RTreeEntry &candidate) {
+            return candidate.data == entry.data && memcmp(&candidate.bounds, &entry.bounds, sizeof(RTreeBounds)) == 0;
+        });
+        if (buffered != delta.end()) {
+            *buffered = delta.back();
+            delta.pop_back();
+            removed++;
+            continue;
+        }
+        if (tree->Delete(entry.bounds, NumericCast<row_t>(entry.data))) {
+            removed++;
+        }
+    }
+    index_size -= removed;
 }
 //------------------------------------------------------------------------------
 // RTree Search Operations
 //------------------------------------------------------------------------------
-unique_ptr<IndexScanState> RTreeIndex::InitializeScan(const void* query_blob, size_t blob_size) const {
-
-    const uint8_t *stbox_data = reinterpret_cast<const uint8_t*>(query_blob);
-    STBox *box = (STBox*)malloc(blob_size);
-    memcpy(box, stbox_data, blob_size);
+bool RTreeIndex::TryGetQueryBounds(const Value &query, RTreeBounds &result) const {
+    if (query.IsNull()) {
+        return false;
+    }
+    const auto &type = query.type();
+    const auto is_number = IsNumberType(unbound_expressions[0]->return_type);
+    auto &blob = StringValue::Get(query);
+    if (type == TboxType::TBOX()) {
+        if (!is_number || blob.size() < sizeof(TBox)) {
+            return false;
+        }
+        TBox box;
+        memcpy(&box, blob.data(), sizeof(TBox));
+        result = RTreeBounds::FromTBox(box);
+        return true;
+    }
+    if (is_number) {
+        return false;
+    }
+    if (type == SpanTypes::TSTZSPAN()) {
+        // A period only constrains the time axis of the query box
+        if (blob.size() < sizeof(Span)) {
+            return false;
+        }
+        Span span;
+        memcpy(&span, blob.data(), sizeof(Span));
+        STBox *span_box = tstzspan_to_stbox(&span);
+        if (!span_box) {
+            return false;
+        }
+        result = RTreeBounds::FromSTBox(*span_box);
+        free(span_box);
+        return true;
+    }
+    if (type != StboxType::STBOX() || blob.size() < sizeof(STBox)) {
+        return false;
+    }
+    STBox box;
+    memcpy(&box, blob.data(), sizeof(STBox));
+    // A query in another reference system is left to the filter, which raises the SRID error
+    if (!GetSpace().IsCompatible(box)) {
+        return false;
+    }
+    result = RTreeBounds::FromSTBox(box);
+    return true;
+}
 
+unique_ptr<IndexScanState> RTreeIndex::InitializeScan(const RTreeBounds &query, RTreePredicate predicate) const {
     auto state = make_uniq<RTreeIndexScanState>();
+    state->query = query;
+    state->predicate = predicate;
+    state->deduplicate = IsMultiEntry();
+    auto tree_lock = rwlock.GetSharedLock();
+    StartScan(*state);
+    state->initialized = true;
     
-    memcpy(&state->query_stbox, box, sizeof(STBox));
+    return std::move(state);
+}
 
-    int32_t query_srid = stbox_srid(&state->query_stbox);
-    
-    if (query_srid != 0) {
-        STBox *normalized_query = stbox_set_srid(&state->query_stbox, 0);
-        if (normalized_query) {
-            memcpy(&state->query_stbox, normalized_query, sizeof(STBox));
-            free(normalized_query);
-        }
+void RTreeIndex::StartScan(IndexScanState &state) const {
+    auto &sstate = state.Cast<RTreeIndexScanState>();
+    if (sstate.nearest) {
+        tree->InitializeNearestScan(sstate.nearest_cursor, sstate.query);
+    } else {
+        tree->InitializeScan(sstate.cursor, sstate.query, sstate.predicate);
     }
-    if (rtree_) {
-        state->search_results = SearchStbox(&state->query_stbox);
-        state->initialized = true;
+    sstate.delta_rows.clear();
+    sstate.delta_offset = 0;
+    lock_guard<mutex> guard(buffer_lock);
+    for (auto &entry : delta) {
+        if (sstate.nearest) {
+            // Buffered appends compete with the tree entries in the same distance order
+            sstate.nearest_cursor.queue.push({entry.bounds.MinDistance(sstate.query), entry.data, true});
+        } else if (TRTree::MatchesLeaf(entry.bounds, sstate.cursor)) {
+            sstate.delta_rows.push_back(NumericCast<row_t>(entry.data));
+        }
     }
-    
-    state->current_position = 0;
-    
-    return std::move(state);
 }
 
 idx_t RTreeIndex::Scan(IndexScanState &state, Vector &result) const {
+    return Scan(state, FlatVector::GetData<row_t>(result), STANDARD_VECTOR_SIZE);
+}
+
+idx_t RTreeIndex::Scan(IndexScanState &state, row_t *row_ids, idx_t capacity) const {
     auto &sstate = state.Cast<RTreeIndexScanState>();
     
-    if (!sstate.initialized || sstate.search_results.empty()) {
+    if (!sstate.initialized) {
         return 0;
     }
 
-    const auto row_ids = FlatVector::GetData<row_t>(result);
-    
-    idx_t output_idx = 0;
-    const idx_t max_output = STANDARD_VECTOR_SIZE;
+    // The tree is latched for this call only, a writer waits for at most one call of each open scan
+    auto tree_lock = rwlock.GetSharedLock();
 
-    while (sstate.current_position < sstate.search_results.size() && 
-           output_idx < max_output) {
-        
-        row_ids[output_idx] = sstate.search_results[sstate.current_position];
-        output_idx++;
-        sstate.current_position++;
+    idx_t result_count = 0;
+    while (result_count < capacity) {
+        const auto request = capacity - result_count;
+        idx_t row_count;
+        if (sstate.nearest) {
+            row_count = tree->NearestScan(sstate.nearest_cursor, row_ids + result_count, request);
+        } else if (sstate.delta_offset < sstate.delta_rows.size()) {
+            row_count = MinValue(request, sstate.delta_rows.size() - sstate.delta_offset);
+            memcpy(row_ids + result_count, sstate.delta_rows.data() + sstate.delta_offset, row_count * sizeof(row_t));
+            sstate.delta_offset += row_count;
+        } else {
+            row_count = tree->Scan(sstate.cursor, row_ids + result_count, request);
+        }
+        if (row_count == 0) {
+            break;
+        }
+        if (sstate.deduplicate) {
+            // A split value matches once per fragment, only the first match is emitted
+            const auto end = result_count + row_count;
+            row_count = 0;
+            for (auto i = result_count; i < end; i++) {
+                if (sstate.emitted.insert(row_ids[i]).second) {
+                    row_ids[result_count + row_count++] = row_ids[i];
+                }
+            }
+        }
+        result_count += row_count;
     }
-    
-    return output_idx;
+    return result_count;
+}
+
+unique_ptr<IndexScanState> RTreeIndex::InitializeNearestScan(const RTreeBounds &query) const {
+    auto state = make_uniq<RTreeIndexScanState>();
+    state->query = query;
+    state->nearest = true;
+    state->deduplicate = IsMultiEntry();
+    auto tree_lock = rwlock.GetSharedLock();
+    StartScan(*state);
+    state->initialized = true;
+    return std::move(state);
 }
 
 
+unique_ptr<IndexScanState> RTreeIndex::InitializeBatchScan(vector<RTreeBounds> queries) const {
+    auto state = make_uniq<RTreeIndexBatchScanState>();
+    state->deduplicate = IsMultiEntry();
+    if (state->deduplicate) {
+        state->emitted.resize(queries.size());
+    }
+    state->cursor.queries = std::move(queries);
+    auto tree_lock = rwlock.GetSharedLock();
+    StartBatchScan(*state);
+    return std::move(state);
+}
+
+void RTreeIndex::StartBatchScan(IndexScanState &state) const {
+    auto &bstate = state.Cast<RTreeIndexBatchScanState>();
+    auto queries = bstate.cursor.queries;
+    bstate.delta_pairs.clear();
+    bstate.delta_offset = 0;
+    {
+        lock_guard<mutex> guard(buffer_lock);
+        for (auto &entry : delta) {
+            for (idx_t i = 0; i < queries.size(); i++) {
+                if (entry.bounds.Intersects(queries[i])) {
+                    bstate.delta_pairs.emplace_back(NumericCast<uint32_t>(i), NumericCast<row_t>(entry.data));
+                }
+            }
+        }
+    }
+    tree->InitializeBatchScan(bstate.cursor, std::move(queries));
+}
+
+idx_t RTreeIndex::BatchScan(IndexScanState &state, DataChunk &result) const {
+    auto &bstate = state.Cast<RTreeIndexBatchScanState>();
+    const auto query_ids = FlatVector::GetData<uint32_t>(result.data[0]);
+    const auto row_ids = FlatVector::GetData<row_t>(result.data[1]);
+
+    // The tree is latched for this call only, a writer waits for at most one call of each open scan
+    auto tree_lock = rwlock.GetSharedLock();
+
+    idx_t result_count = 0;
+    while (result_count < STANDARD_VECTOR_SIZE) {
+        const auto request = STANDARD_VECTOR_SIZE - result_count;
+        idx_t pair_count;
+        if (bstate.delta_offset < bstate.delta_pairs.size()) {
+            pair_count = MinValue(request, bstate.delta_pairs.size() - bstate.delta_offset);
+            for (idx_t i = 0; i < pair_count; i++) {
+                auto &match = bstate.delta_pairs[bstate.delta_offset++];
+                query_ids[result_count + i] = match.first;
+                row_ids[result_count + i] = match.second;
+            }
+        } else {
+            pair_count = tree->BatchScan(bstate.cursor, query_ids + result_count, row_ids + result_count, request);
+        }
+        if (pair_count == 0) {
+            break;
+        }
+        if (bstate.deduplicate) {
+            // A split value matches once per fragment, only the first match with each query is emitted
+            const auto end = result_count + pair_count;
+            pair_count = 0;
+            for (auto i = result_count; i < end; i++) {
+                if (bstate.emitted[query_ids[i]].insert(row_ids[i]).second) {
+                    query_ids[result_count + pair_count] = query_ids[i];
+                    row_ids[result_count + pair_count++] = row_ids[i];
+                }
+            }
+        }
+        result_count += pair_count;
+    }
+    result.SetCardinality(result_count);
+    return result_count;
+}
+
 vector<row_t> RTreeIndex::SearchStbox(const STBox *query_stbox) const {
     vector<row_t> results;
     
-    if (!rtree_ || !query_stbox) {
+    if (!query_stbox) {
         return results;
     }
 
-    int count = 0;
-    int *ids = nullptr;
-    
-    try {
-        ids = rtree_search(rtree_, (const void*)query_stbox, &count);
-        
-        if (ids && count > 0) {
-            results.reserve(count);
-            for (int i = 0; i < count; i++) {
-                results.push_back(static_cast<row_t>(ids[i]));
+    Search(RTreeBounds::FromSTBox(*query_stbox), results);
+    return results;
+}
+
+idx_t RTreeIndex::EstimateCardinality(const RTreeBounds &query) const {
+    auto tree_lock = rwlock.GetSharedLock();
+    auto estimate = tree->EstimateCount(query, ESTIMATE_NODE_BUDGET);
+    {
+        lock_guard<mutex> guard(buffer_lock);
+        for (auto &entry : delta) {
+            if (entry.bounds.Intersects(query)) {
+                estimate += 1;
             }
         }
-    } catch (...) {
-        fprintf(stderr, "Exception during rtree_search - likely SRID mismatch\n");
     }
-    
-    if (ids) {
-        free(ids);
+    // Fragments of split values are counted individually, so this is an upper bound for them
+    return MinValue(LossyNumericCast<idx_t>(std::ceil(estimate)), GetEntryCount());
+}
+
+void RTreeIndex::Search(const RTreeBounds &query, vector<row_t> &result) const {
+    const auto start = result.size();
+    {
+        auto tree_lock = rwlock.GetSharedLock();
+        tree->Search(query, result);
+        lock_guard<mutex> guard(buffer_lock);
+        for (auto &entry : delta) {
+            if (entry.bounds.Intersects(query)) {
+                result.push_back(NumericCast<row_t>(entry.data));
+            }
+        }
+    }
+    if (IsMultiEntry()) {
+        std::sort(result.begin() + NumericCast<int64_t>(start), result.end());
+        result.erase(std::unique(result.begin() + NumericCast<int64_t>(start), result.end()), result.end());
     }
-    
-    return results;
 }
 
 //------------------------------------------------------------------------------
@@ -355,47 +857,104 @@ vector<row_t> RTreeIndex::SearchStbox(const STBox *query_stbox) const {
 //------------------------------------------------------------------------------
 
 void RTreeIndex::CommitDrop(IndexLock &index_lock) {
-    if (rtree_) {
-        rtree_free(rtree_);
-        rtree_ = nullptr;
+    auto tree_lock = LockTreeExclusive();
+    tree->Reset();
+    lock_guard<mutex> guard(buffer_lock);
+    delta.clear();
+    index_size = 0;
+}
+
+IndexStorageInfo RTreeIndex::GetStorageInfo(const case_insensitive_map_t<Value> &options, const bool to_wal) {
+    // Only the tree is persisted, the buffers are written while no scan reads them. Nodes retired for open
+    // cursors are written as well and freed once the cursors are done.
+    auto tree_lock = LockTreeExclusive();
+    FlushDelta();
+
+    IndexStorageInfo info(name);
+    info.root = tree->GetRoot().Get();
+    info.options = options;
+    info.options[ENTRY_COUNT_OPTION] = Value::UBIGINT(GetEntryCount());
+    GetSpace().Serialize(info.options);
+
+    auto &allocator = tree->GetAllocator();
+    if (!to_wal) {
+        // Write all dirty node buffers through the partial block manager
+        auto &block_manager = table_io_manager.GetIndexBlockManager();
+        PartialBlockManager partial_block_manager(block_manager, PartialBlockType::FULL_CHECKPOINT);
+        allocator.SerializeBuffers(partial_block_manager);
+        partial_block_manager.FlushPartialBlocks();
+    } else {
+        info.buffers.push_back(allocator.InitSerializationToWAL());
     }
+    info.allocator_infos.push_back(allocator.GetInfo());
+    return info;
 }
 
 bool RTreeIndex::MergeIndexes(IndexLock &state, BoundIndex &other_index) {
-    // MEOS RTree doesn't have built-in merge operation
-    return false;
+    auto &other = other_index.Cast<RTreeIndex>();
+    // A reference system mismatch throws before any entry of the other index moves
+    MergeSpace(other.GetSpace());
+    auto tree_lock = LockTreeExclusive();
+    tree->ReleaseRetired();
+    tree->Merge(*other.tree);
+    bool full;
+    {
+        lock_guard<mutex> guard(buffer_lock);
+        delta.insert(delta.end(), other.delta.begin(), other.delta.end());
+        other.delta.clear();
+        full = delta.size() >= DELTA_CAPACITY;
+    }
+    index_size += other.index_size.exchange(0);
+    if (full) {
+        FlushDelta();
+    }
+    return true;
 }
 
 void RTreeIndex::Vacuum(IndexLock &lock) {
-    // Could potentially rebuild the tree for better performance
-    // For now, no-op
+    // Vacuuming is only an opportunity, it is skipped while a scan reads the tree
+    auto tree_lock = rwlock.TryGetExclusiveLock();
+    if (!tree_lock) {
+        return;
+    }
+    FlushDelta();
+    // Deletes leave nodes partially filled, repack them once too much of the allocated space is unused.
+    // Repacking replaces every node, it waits until no cursor holds a snapshot that would keep them all.
+    if (!tree->HasOpenSnapshots() && tree->GetEmptySlots() > VACUUM_EMPTY_SLOTS) {
+        tree->Repack();
+    }
 }
 
 idx_t RTreeIndex::GetInMemorySize(IndexLock &state) {
-    // Since RTree is opaque, we can't access internal structure
-    // Return estimated size or implement a size function in MEOS
-    return rtree_ ? 1024 : 0; // Placeholder
+    auto tree_lock = rwlock.GetSharedLock();
+    lock_guard<mutex> guard(buffer_lock);
+    return tree->GetInMemorySize() + delta.capacity() * sizeof(RTreeEntry);
 }
 
 string RTreeIndex::VerifyAndToString(IndexLock &state, const bool only_verify) {
-    if (!rtree_) {
-        return "Stbox R-tree Index (not initialized)";
+    auto tree_lock = rwlock.GetSharedLock();
+    tree->Verify();
+    if (only_verify) {
+        return string();
     }
-    
-    // Since RTree is opaque, we can't access dims directly
-    // You might need a MEOS function to get tree properties
-    return "Stbox R-tree Index (MEOS-based)";
+    return tree->ToString(false) +
+           StringUtil::Format("\nTRTREE delta, %d buffered entries", GetBufferedCount(state));
 }
 
 void RTreeIndex::VerifyAllocations(IndexLock &lock) {
-    // Verify RTree structure integrity
-    // Since RTree is opaque, limited verification possible
-    // Could implement tree validation function in MEOS if needed
+    // Every live segment of the node allocator has to be reachable from the root, or retired for a cursor
+    auto tree_lock = rwlock.GetSharedLock();
+    auto node_count = tree->Verify() + tree->GetRetiredCount();
+    auto segment_count = tree->GetAllocator().GetSegmentCount();
+    if (node_count != segment_count) {
+        throw InternalException("TRTREE index \"%s\" reaches %d nodes but its allocator holds %d segments", name,
+                                node_count, segment_count);
+    }
 }
 
 string RTreeIndex::GetConstraintViolationMessage(VerifyExistenceType verify_type, idx_t failed_index,
                                                DataChunk &input) {
-    return "Stbox R-tree constraint violation (interval index does not support constraints)";
+    return "TRTREE constraint violation (TRTREE indexes do not support constraints)";
 }
 
 bool RTreeIndex::TryMatchDistanceFunction(const unique_ptr<Expression> &expr,
@@ -403,6 +962,167 @@ bool RTreeIndex::TryMatchDistanceFunction(const unique_ptr<Expression> &expr,
     return function_matcher->Match(*expr, bindings);
 }
 
+bool RTreeIndex::TryMatchNearestFunction(const unique_ptr<Expression> &expr,
+                                         vector<reference<Expression>> &bindings) const {
+    return nearest_matcher->Match(*expr, bindings);
+}
+
+bool RTreeIndex::TryBindIndexExpression(LogicalGet &get, unique_ptr<Expression> &result) const {
+    auto &column_ids = get.GetColumnIds();
+
+    // The index expressions refer to the table columns by their index in the table
+    function<bool(unique_ptr<Expression> &)> bind_index_expr = [&](unique_ptr<Expression> &expr) -> bool {
+        if (expr->type == ExpressionType::BOUND_COLUMN_REF) {
+            auto &bound_colref = expr->Cast<BoundColumnRefExpression>();
+            for (idx_t i = 0; i < column_ids.size(); i++) {
+                if (column_ids[i].GetPrimaryIndex() == bound_colref.binding.column_index) {
+                    // Scanned columns are bound by their position in the column ids, also when projected away
+                    bound_colref.binding = ColumnBinding(get.table_index, i);
+                    return true;
+                }
+            }
+            return false;
+        }
+        bool success = true;
+        ExpressionIterator::EnumerateChildren(*expr, [&](unique_ptr<Expression> &child) {
+            if (success) {
+                success = bind_index_expr(child);
+            }
+        });
+        return success;
+    };
+
+    auto expr_ptr = unbound_expressions[0]->Copy();
+    if (!bind_index_expr(expr_ptr)) {
+        return false;
+    }
+    result = std::move(expr_ptr);
+    return true;
+}
+
+//! Whether the box expression is the box of the operand, `stbox(x)` / `x::STBOX` or `tbox(x)` / `x::TBOX`
+static bool IsBoxOf(const Expression &box_expr, const Expression &operand) {
+    const auto box_type = RTreeIndex::GetBoxType(operand.return_type);
+    if (box_expr.return_type != box_type) {
+        return false;
+    }
+    if (box_expr.GetExpressionClass() == ExpressionClass::BOUND_CAST) {
+        return box_expr.Cast<BoundCastExpression>().child->Equals(operand);
+    }
+    if (box_expr.GetExpressionClass() == ExpressionClass::BOUND_FUNCTION) {
+        auto &func = box_expr.Cast<BoundFunctionExpression>();
+        const auto name = box_type == TboxType::TBOX() ? "tbox" : "stbox";
+        return func.function.name == name && func.children.size() == 1 && func.children[0]->Equals(operand);
+    }
+    return false;
+}
+
+bool RTreeIndex::IsIndexedBox(const Expression &operand, const Expression &index_expr) {
+    if (operand.return_type != GetBoxType(index_expr.return_type)) {
+        return false;
+    }
+    return operand.Equals(index_expr) || (IsTemporalType(index_expr.return_type) && IsBoxOf(operand, index_expr));
+}
+
+bool RTreeIndex::IsIndexedValue(const Expression &operand, const Expression &index_expr) {
+    if (IsTemporalType(index_expr.return_type)) {
+        return operand.Equals(index_expr);
+    }
+    return IsBoxOf(index_expr, operand);
+}
+
+//! Whether the query operand is a box of the indexed kind, or a TSTZSPAN for an STBOX index if spans are allowed,
+//! that the filter can use
+static bool IsQueryOperand(const Expression &query, const Expression &index_expr, bool constant_query,
+                           bool allow_span) {
+    if (constant_query && !query.IsFoldable()) {
+        return false;
+    }
+    const auto box_type = RTreeIndex::GetBoxType(index_expr.return_type);
+    return query.return_type == box_type ||
+           (allow_span && box_type == StboxType::STBOX() && query.return_type == SpanTypes::TSTZSPAN());
+}
+
+bool RTreeIndex::TryMatchPredicate(const Expression &expr, const Expression &index_expr,
+                                   RTreeIndexPredicate &result, bool constant_query) {
+    if (expr.type == ExpressionType::OPERATOR_IS_NOT_NULL) {
+        // The restriction is not empty only if the value has a point in the box, that is in one of its fragments
+        auto &child = *expr.Cast<BoundOperatorExpression>().children[0];
+        if (child.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+            return false;
+        }
+        auto &restriction = child.Cast<BoundFunctionExpression>();
+        if (restriction.function.name != "atStbox" || restriction.children.size() != 2 ||
+            !IsIndexedValue(*restriction.children[0], index_expr) ||
+            !IsQueryOperand(*restriction.children[1], index_expr, constant_query, false)) {
+            return false;
+        }
+        result.predicate = RTreePredicate::OVERLAPS;
+        result.query = restriction.children[1].get();
+        result.exact = false;
+        result.fragment_safe = true;
+        return true;
+    }
+    if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+        return false;
+    }
+    auto &func = expr.Cast<BoundFunctionExpression>();
+    auto &name = func.function.name;
+    if (func.children.size() != 2 || (name != "&&" && name != "@>" && name != "<@")) {
+        return false;
+    }
+
+    for (idx_t side = 0; side < 2; side++) {
+        auto &indexed = *func.children[side];
+        auto &query = *func.children[1 - side];
+        if (!IsQueryOperand(query, index_expr, constant_query, true)) {
+            continue;
+        }
+        const auto is_box = IsIndexedBox(indexed, index_expr);
+        if (!is_box && !IsIndexedValue(indexed, index_expr)) {
+            continue;
+        }
+
+        if (name == "&&") {
+            result.predicate = RTreePredicate::OVERLAPS;
+        } else if ((name == "@>") == (side == 0)) {
+            result.predicate = RTreePredicate::CONTAINS;
+        } else {
+            result.predicate = RTreePredicate::CONTAINED_BY;
+        }
+        result.query = &query;
+        // Overlap of two STBOXes is exactly what the tree tests. Containment between boxes of different
+        // dimensionality, operators on the temporal values themselves and TBOX value bounds, which the tree
+        // keeps inclusive, are rechecked.
+        result.exact = is_box && result.predicate == RTreePredicate::OVERLAPS &&
+                       query.return_type == StboxType::STBOX();
+        // A value is contained in the query only if all of its fragments are. Overlap and containment of the
+        // whole box can hold without any fragment box passing the same test.
+        result.fragment_safe = result.predicate == RTreePredicate::CONTAINED_BY;
+        return true;
+    }
+    return false;
+}
+
+unique_ptr<ExpressionMatcher> RTreeIndex::MakeNearestMatcher() const {
+    unordered_set<string> distance_functions = {"<->", "nearestApproachDistance"};
+
+    auto matcher = make_uniq<FunctionExpressionMatcher>();
+    matcher->function = make_uniq<ManyFunctionMatcher>(distance_functions);
+    matcher->expr_type = make_uniq<SpecificExpressionTypeMatcher>(ExpressionType::BOUND_FUNCTION);
+    matcher->policy = SetMatcher::Policy::UNORDERED;
+
+    auto lhs_matcher = make_uniq<ExpressionMatcher>();
+    lhs_matcher->type = make_uniq<SpecificTypeMatcher>(StboxType::STBOX());
+    matcher->matchers.push_back(std::move(lhs_matcher));
+
+    auto rhs_matcher = make_uniq<ExpressionMatcher>();
+    rhs_matcher->type = make_uniq<SpecificTypeMatcher>(StboxType::STBOX());
+    matcher->matchers.push_back(std::move(rhs_matcher));
+
+    return std::move(matcher);
+}
+
 unique_ptr<ExpressionMatcher> RTreeIndex::MakeFunctionMatcher() const {
     // Create matcher for the && (overlaps) operator
     unordered_set<string> overlap_functions = {"&&"};
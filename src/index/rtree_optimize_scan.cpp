@@ -5,10 +5,18 @@
 #include "duckdb/planner/operator/logical_get.hpp"
 #include "duckdb/planner/operator/logical_projection.hpp"
 #include "duckdb/planner/operator/logical_top_n.hpp"
+#include "duckdb/parser/constraints/not_null_constraint.hpp"
 #include "duckdb/planner/operator/logical_filter.hpp"
 #include "duckdb/planner/filter/expression_filter.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/column_binding_map.hpp"
+#include "duckdb/planner/logical_operator_visitor.hpp"
 
 #include "duckdb/main/database.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/data_table.hpp"
 #include <algorithm>
 
 #include "index/rtree_module.hpp"
@@ -35,60 +43,82 @@ private:
         auto &duck_table = get.GetTable()->Cast<DuckTableEntry>();
         auto &table_info = *get.GetTable()->GetStorage().GetDataTableInfo();
         
+        double max_selectivity = RTreeIndexScanFunction::DEFAULT_MAX_SELECTIVITY;
+        Value setting;
+        if (context.TryGetCurrentSetting(RTreeIndexScanFunction::MAX_SELECTIVITY_SETTING, setting)) {
+            max_selectivity = setting.GetValue<double>();
+        }
+        const auto total_rows = duck_table.GetStorage().GetTotalRows();
+
         unique_ptr<RTreeIndexScanBindData> bind_data = nullptr;
-        vector<reference<Expression>> bindings;
+        auto &column_ids = get.GetColumnIds();
+        // The last index left out because its filter selects too much of the table
+        string skipped_index;
+        double skipped_selectivity = 0;
 
         for (auto &filter_pair : get.table_filters.filters) {
             auto &filter = filter_pair.second;
-            
+            if (filter->filter_type != TableFilterType::EXPRESSION_FILTER) {
+                continue;
+            }
+            // Table filters are keyed by the table column, the scan sees it at its position in the column ids
+            optional_idx filter_column;
+            for (idx_t i = 0; i < column_ids.size(); i++) {
+                if (!column_ids[i].IsRowIdColumn() && column_ids[i].GetPrimaryIndex() == filter_pair.first) {
+                    filter_column = i;
+                    break;
+                }
+            }
+            if (!filter_column.IsValid()) {
+                continue;
+            }
+            auto &expr_filter = filter->Cast<ExpressionFilter>();
+            auto filter_expr = BindFilterColumn(get, filter_column.GetIndex(), *expr_filter.expr);
+
             table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, 
             [&](RTreeIndex &rtree_index) -> bool {
-                bindings.clear();
-
-                auto &expr_filter = filter->Cast<ExpressionFilter>();
-                if (!rtree_index.TryMatchDistanceFunction(expr_filter.expr, bindings)) {
+                unique_ptr<Expression> index_expr;
+                if (!rtree_index.TryBindIndexExpression(get, index_expr)) {
                     return false;
                 }
 
-                Expression *const_expr = nullptr;
-                
-                for (auto &binding : bindings) {
-                    if (binding.get().type == ExpressionType::VALUE_CONSTANT) {
-                        const_expr = &binding.get();
-                    } 
-                }
-
-                if (!const_expr) {
+                RTreeIndexPredicate predicate;
+                if (!RTreeIndex::TryMatchPredicate(*filter_expr, *index_expr, predicate)) {
                     return false;
                 }
-
-                const auto &constant = const_expr->Cast<BoundConstantExpression>();
-                
-                unique_ptr<STBox> query_stbox = nullptr;
-                
-                if (constant.value.type().id() == LogicalTypeId::BLOB) {
-                    
-                    auto blob_data = constant.value.GetValueUnsafe<duckdb::string_t>();
-
-                    const uint8_t *stbox_data = reinterpret_cast<const uint8_t *>(blob_data.GetDataUnsafe());
-                    size_t stbox_size = blob_data.GetSize();
-
-                    STBox *box = nullptr;
-                    
-                    box = (STBox*)malloc(stbox_size);
-                    
-                    memcpy(box, stbox_data, stbox_size);
-
-                    query_stbox = unique_ptr<STBox>(box);
-                    
+                if (rtree_index.IsMultiEntry()) {
+                    // Rows are found through the boxes of their fragments
+                    if (!predicate.fragment_safe) {
+                        return false;
+                    }
+                    predicate.exact = false;
                 }
 
-                if (!query_stbox) {
+                auto query = TryGetQueryBounds(context, rtree_index, *predicate.query);
+                if (!query) {
                     return false;
                 }
 
+                // Lossy matches are estimated by their box test, which only overestimates
+                const auto estimate = MaxValue<idx_t>(1, MinValue(rtree_index.EstimateCardinality(*query),
+                                                                  MaxValue<idx_t>(1, total_rows)));
+                const auto selectivity =
+                    static_cast<double>(estimate) / static_cast<double>(MaxValue<idx_t>(1, total_rows));
+                // Fetching a large part of the table row by row is slower than a parallel sequential scan
+                if (selectivity > max_selectivity) {
+                    skipped_index = rtree_index.GetIndexName();
+                    skipped_selectivity = selectivity;
+                    return false;
+                }
                 bind_data = make_uniq<RTreeIndexScanBindData>(
-                    duck_table, rtree_index, 1000, std::move(query_stbox));
+                    duck_table, rtree_index, 0, std::move(query));
+                bind_data->estimated_cardinality = estimate;
+                bind_data->selectivity = selectivity;
+                bind_data->max_selectivity = max_selectivity;
+                bind_data->predicate = predicate.predicate;
+                bind_data->filter_column = filter_column.GetIndex();
+                bind_data->exact = predicate.exact;
+                bind_data->max_threads = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
                 return true;
             });
             
@@ -98,12 +128,14 @@ private:
         }
 
         if (!bind_data) {
+            if (!skipped_index.empty() && get.bind_data) {
+                KeepSequentialScan(get, skipped_index, skipped_selectivity, max_selectivity);
+            }
             return false;
         }
-        auto cardinality = get.function.cardinality(context, bind_data.get());
         get.function = RTreeIndexScanFunction::GetFunction();
-        get.has_estimated_cardinality = cardinality->has_estimated_cardinality;
-        get.estimated_cardinality = cardinality->estimated_cardinality;
+        get.has_estimated_cardinality = true;
+        get.estimated_cardinality = bind_data->estimated_cardinality;
         get.bind_data = std::move(bind_data);
 
         if (!get.bind_data) {
@@ -113,6 +145,163 @@ private:
         return true;
     }
 
+    //! Record on the sequential scan the estimate that kept it, EXPLAIN shows it next to the scanned table
+    static void KeepSequentialScan(LogicalGet &get, const string &index_name, double selectivity,
+                                   double max_selectivity) {
+        auto &scan = get.bind_data->Cast<TableScanBindData>();
+        auto scan_to_string = get.function.to_string;
+        if (scan_to_string == RTreeKeptScanBindData::ToString) {
+            // Optimized again, the scan is still shown the way the table function shows it
+            scan_to_string = scan.Cast<RTreeKeptScanBindData>().scan_to_string;
+        }
+        get.bind_data =
+            make_uniq<RTreeKeptScanBindData>(scan, index_name, selectivity, max_selectivity, scan_to_string);
+        get.function.to_string = RTreeKeptScanBindData::ToString;
+    }
+
+    //! Evaluate a constant query operand into the box the index is searched with, returns nullptr if the
+    //! index cannot answer it
+    static unique_ptr<RTreeBounds> TryGetQueryBounds(ClientContext &context, const RTreeIndex &rtree_index,
+                                                     const Expression &expr) {
+        if (!expr.IsFoldable()) {
+            return nullptr;
+        }
+        auto result = make_uniq<RTreeBounds>();
+        if (!rtree_index.TryGetQueryBounds(ExpressionExecutor::EvaluateScalar(context, expr), *result)) {
+            return nullptr;
+        }
+        return result;
+    }
+
+    //! Replace the column placeholder of a table filter with a reference to the filtered column of the get
+    static unique_ptr<Expression> BindFilterColumn(LogicalGet &get, idx_t column_idx, const Expression &expr) {
+        auto result = expr.Copy();
+        ExpressionIterator::EnumerateExpression(result, [&](unique_ptr<Expression> &child) {
+            if (child->GetExpressionClass() == ExpressionClass::BOUND_REF) {
+                child = make_uniq<BoundColumnRefExpression>(child->return_type,
+                                                            ColumnBinding(get.table_index, column_idx));
+            }
+        });
+        return result;
+    }
+
+    //! Whether every table column the indexed expression reads is declared NOT NULL, so that every row has
+    //! an entry in the index
+    static bool IsKeyNotNull(DuckTableEntry &table, const RTreeIndex &rtree_index) {
+        unordered_set<idx_t> not_null;
+        for (auto &constraint : table.GetConstraints()) {
+            if (constraint->type == ConstraintType::NOT_NULL) {
+                not_null.insert(constraint->Cast<NotNullConstraint>().index.index);
+            }
+        }
+        bool result = true;
+        std::function<void(const Expression &)> visit = [&](const Expression &expr) {
+            if (expr.type == ExpressionType::BOUND_COLUMN_REF) {
+                result = result && not_null.count(expr.Cast<BoundColumnRefExpression>().binding.column_index) > 0;
+                return;
+            }
+            ExpressionIterator::EnumerateChildren(expr, visit);
+        };
+        visit(*rtree_index.unbound_expressions[0]);
+        return result;
+    }
+
+    //! Rewrite TOP N(ORDER BY col <-> const) over PROJECTION over GET into a nearest neighbour index scan.
+    //! The TOP N stays in place to order the k rows and to apply the offset.
+    static bool TryOptimizeTopN(ClientContext &context, unique_ptr<LogicalOperator> &plan) {
+        auto &top_n = plan->Cast<LogicalTopN>();
+
+        if (top_n.orders.size() != 1) {
+            return false;
+        }
+        const auto &order = top_n.orders[0];
+        if (order.type != OrderType::ASCENDING || order.expression->type != ExpressionType::BOUND_COLUMN_REF) {
+            return false;
+        }
+        // Rows without a box have no index entry, they may only sort after all k rows
+        if (order.null_order != OrderByNullType::NULLS_LAST) {
+            return false;
+        }
+        if (top_n.children.size() != 1 || top_n.children[0]->type != LogicalOperatorType::LOGICAL_PROJECTION) {
+            return false;
+        }
+        auto &projection = top_n.children[0]->Cast<LogicalProjection>();
+        const auto &order_ref = order.expression->Cast<BoundColumnRefExpression>();
+        if (order_ref.binding.table_index != projection.table_index) {
+            return false;
+        }
+        const auto &distance_expr = projection.expressions[order_ref.binding.column_index];
+
+        if (projection.children.size() != 1 || projection.children[0]->type != LogicalOperatorType::LOGICAL_GET) {
+            return false;
+        }
+        auto &get = projection.children[0]->Cast<LogicalGet>();
+        if (get.function.name != "seq_scan" || !get.GetTable() || !get.GetTable()->IsDuckTable()) {
+            return false;
+        }
+        // Filtered rows would be counted against k
+        if (!get.table_filters.filters.empty()) {
+            return false;
+        }
+
+        auto &duck_table = get.GetTable()->Cast<DuckTableEntry>();
+        auto &table_info = *get.GetTable()->GetStorage().GetDataTableInfo();
+        const auto limit = top_n.limit + top_n.offset;
+
+        unique_ptr<RTreeIndexScanBindData> bind_data = nullptr;
+        vector<reference<Expression>> bindings;
+
+        table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, [&](RTreeIndex &rtree_index) -> bool {
+            // The distance to the nearest fragment is not the distance of the whole box
+            if (rtree_index.IsMultiEntry()) {
+                return false;
+            }
+            // The tree orders by planar distance, the distance of geodetic boxes is geodesic
+            if (rtree_index.GetSpace().geodetic) {
+                return false;
+            }
+            // With fewer than k boxes, the TOP N fills up with the rows whose key is NULL
+            if (!IsKeyNotNull(duck_table, rtree_index)) {
+                return false;
+            }
+            bindings.clear();
+            if (!rtree_index.TryMatchNearestFunction(distance_expr, bindings)) {
+                return false;
+            }
+            unique_ptr<Expression> index_expr;
+            if (!rtree_index.TryBindIndexExpression(get, index_expr)) {
+                return false;
+            }
+
+            // bindings[0] is the function, followed by its two operands in either order
+            unique_ptr<RTreeBounds> query;
+            for (idx_t i = 1; i < bindings.size() && !query; i++) {
+                auto &column_expr = bindings[i].get();
+                auto &const_expr = bindings[i == 1 ? 2 : 1].get();
+                if (RTreeIndex::IsIndexedBox(column_expr, *index_expr)) {
+                    query = TryGetQueryBounds(context, rtree_index, const_expr);
+                }
+            }
+            if (!query) {
+                return false;
+            }
+
+            bind_data = make_uniq<RTreeIndexScanBindData>(duck_table, rtree_index, limit, std::move(query));
+            bind_data->nearest = true;
+            bind_data->estimated_cardinality = limit;
+            return true;
+        });
+
+        if (!bind_data) {
+            return false;
+        }
+        get.function = RTreeIndexScanFunction::GetFunction();
+        get.has_estimated_cardinality = true;
+        get.estimated_cardinality = limit;
+        get.bind_data = std::move(bind_data);
+        return true;
+    }
+
 public:
     static bool TryOptimize(ClientContext &context, unique_ptr<LogicalOperator> &plan) {
         
@@ -120,6 +309,9 @@ public:
                 
             case LogicalOperatorType::LOGICAL_GET:
                 return TryOptimizeLogicalGet(context, plan);
+
+            case LogicalOperatorType::LOGICAL_TOP_N:
+                return TryOptimizeTopN(context, plan);
                 
             default:
                 return false;
@@ -136,9 +328,46 @@ public:
         return optimized;
     }
 
+    //! Collect the bindings that the expressions of the plan read
+    static void CollectReferencedColumns(LogicalOperator &op, column_binding_set_t &result) {
+        LogicalOperatorVisitor::EnumerateExpressions(op, [&](unique_ptr<Expression> *expr) {
+            ExpressionIterator::EnumerateExpression(*expr, [&](unique_ptr<Expression> &child) {
+                if (child->GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+                    result.insert(child->Cast<BoundColumnRefExpression>().binding);
+                }
+            });
+        });
+        for (auto &child : op.children) {
+            CollectReferencedColumns(*child, result);
+        }
+    }
+
+    //! An index scan whose box test decides the filter on its own only scans the filtered column for the
+    //! filter. If nothing above reads it either, the scan does not fetch it.
+    static void SkipUnreadFilterColumns(LogicalOperator &op, const column_binding_set_t &referenced) {
+        if (op.type == LogicalOperatorType::LOGICAL_GET) {
+            auto &get = op.Cast<LogicalGet>();
+            if (get.function.name == RTreeIndexScanFunction::NAME) {
+                auto &bind_data = get.bind_data->Cast<RTreeIndexScanBindData>();
+                const ColumnBinding binding(get.table_index, bind_data.filter_column);
+                if (bind_data.query && bind_data.exact && !bind_data.nearest &&
+                    referenced.find(binding) == referenced.end()) {
+                    bind_data.read_filter_column = false;
+                }
+            }
+        }
+        for (auto &child : op.children) {
+            SkipUnreadFilterColumns(*child, referenced);
+        }
+    }
+
     static void Optimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
-        OptimizeRecursive(input.context, plan);
-        // fprintf(stderr, "Done OptimizeRecursive\n");
+        if (!OptimizeRecursive(input.context, plan)) {
+            return;
+        }
+        column_binding_set_t referenced;
+        CollectReferencedColumns(*plan, referenced);
+        SkipUnreadFilterColumns(*plan, referenced);
     }
 };
 
@@ -1,15 +1,10 @@
+#include "duckdb/catalog/catalog_entry/duck_index_entry.hpp"
 #include "duckdb/catalog/catalog_entry/duck_table_entry.hpp"
-#include "duckdb/catalog/dependency_list.hpp"
-#include "duckdb/common/mutex.hpp"
-#include "duckdb/function/function_set.hpp"
-#include "duckdb/optimizer/matcher/expression_matcher.hpp"
-#include "duckdb/planner/expression_iterator.hpp"
-#include "duckdb/planner/operator/logical_get.hpp"
-#include "duckdb/storage/table/scan_state.hpp"
-#include "duckdb/transaction/duck_transaction.hpp"
-#include "duckdb/transaction/local_storage.hpp"
+#include "duckdb/common/types/value.hpp"
+#include "duckdb/function/pragma_function.hpp"
 #include "duckdb/main/extension_util.hpp"
-#include "duckdb/catalog/catalog_entry/duck_index_entry.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/qualified_name.hpp"
 #include "duckdb/storage/data_table.hpp"
 
 #include "index/rtree_module.hpp"
@@ -33,9 +28,43 @@ static unique_ptr<FunctionData> RTreeIndexInfoBind(ClientContext &context, Table
 	names.emplace_back("table_name");
 	return_types.emplace_back(LogicalType::VARCHAR);
 
-	names.emplace_back("type");
+	// The type of the indexed expression and the dimensions and SRID of its boxes
+	names.emplace_back("key_type");
+	return_types.emplace_back(LogicalType::VARCHAR);
+
+	names.emplace_back("dimensions");
 	return_types.emplace_back(LogicalType::VARCHAR);
 
+	names.emplace_back("srid");
+	return_types.emplace_back(LogicalType::INTEGER);
+
+	names.emplace_back("height");
+	return_types.emplace_back(LogicalType::BIGINT);
+
+	// Node count of each level, leaves first
+	names.emplace_back("level_nodes");
+	return_types.emplace_back(LogicalType::LIST(LogicalType::BIGINT));
+
+	names.emplace_back("node_count");
+	return_types.emplace_back(LogicalType::BIGINT);
+
+	// Leaf entries of the tree and of the append buffer
+	names.emplace_back("entry_count");
+	return_types.emplace_back(LogicalType::BIGINT);
+
+	names.emplace_back("buffered_entries");
+	return_types.emplace_back(LogicalType::BIGINT);
+
+	names.emplace_back("avg_fill");
+	return_types.emplace_back(LogicalType::DOUBLE);
+
+	// Part of the node boxes not covered by their entries
+	names.emplace_back("dead_space");
+	return_types.emplace_back(LogicalType::DOUBLE);
+
+	names.emplace_back("leaf_overlap");
+	return_types.emplace_back(LogicalType::DOUBLE);
+
 	names.emplace_back("memory_usage");
 	return_types.emplace_back(LogicalType::BIGINT);
 
@@ -58,63 +87,24 @@ static unique_ptr<GlobalTableFunctionState> RTreeIndexInfoInitGlobal(ClientConte
 	for (auto &schema : schemas) {
 		schema.get().Scan(context, CatalogType::INDEX_ENTRY, [&](CatalogEntry &entry) {
 			auto &index_entry = entry.Cast<IndexCatalogEntry>();
-
-			if (index_entry.index_type == RTreeIndex::TYPE_NAME || 
-			    index_entry.index_type == "TRTREE") {
+			if (index_entry.index_type == RTreeIndex::TYPE_NAME) {
 				result->entries.push_back(index_entry);
 			}
 		});
 	}
-	
-	
 	return std::move(result);
 }
 
 //-------------------------------------------------------------------------
-// EXECUTE - Output information about RTree indexes
+// Helper function to find the RTree index of a catalog entry
 //-------------------------------------------------------------------------
-static void RTreeIndexInfoExecute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-	auto &data = data_p.global_state->Cast<RTreeIndexInfoGlobalState>();
-	if (data.offset >= data.entries.size()) {
-		return;
+static optional_ptr<RTreeIndex> TryGetRTreeIndex(ClientContext &context, TableCatalogEntry &table_entry,
+                                                 const string &index_name) {
+	if (!table_entry.IsDuckTable()) {
+		return nullptr;
 	}
-
-	idx_t row = 0;
-	while (data.offset < data.entries.size() && row < STANDARD_VECTOR_SIZE) {
-		auto &index_entry = data.entries[data.offset++].get();
-		auto &table_entry = index_entry.schema.catalog.GetEntry<TableCatalogEntry>(context, index_entry.GetSchemaName(),
-		                                                                           index_entry.GetTableName());
-
-		idx_t col = 0;
-		output.data[col++].SetValue(row, Value(index_entry.catalog.GetName()));
-		output.data[col++].SetValue(row, Value(index_entry.schema.name));
-		output.data[col++].SetValue(row, Value(index_entry.name));
-		output.data[col++].SetValue(row, Value(table_entry.name));
-		output.data[col++].SetValue(row, Value("TRTREE (Stbox)"));
-		output.data[col++].SetValue(row, Value::BIGINT(8192)); 
-
-		row++;
-	}
-	output.SetCardinality(row);
-}
-
-//-------------------------------------------------------------------------
-// Helper function to find RTree index by name
-//-------------------------------------------------------------------------
-static optional_ptr<RTreeIndex> TryGetRTreeIndex(ClientContext &context, const string &index_name) {
-	auto qname = QualifiedName::Parse(index_name);
-
-	Binder::BindSchemaOrCatalog(context, qname.catalog, qname.schema);
-	auto &index_entry = Catalog::GetEntry(context, CatalogType::INDEX_ENTRY, qname.catalog, qname.schema, qname.name)
-	                        .Cast<IndexCatalogEntry>();
-	auto &table_entry = Catalog::GetEntry(context, CatalogType::TABLE_ENTRY, qname.catalog, index_entry.GetSchemaName(),
-	                                      index_entry.GetTableName())
-	                        .Cast<TableCatalogEntry>();
-
-	auto &storage = table_entry.GetStorage();
 	RTreeIndex *rtree_index = nullptr;
-
-	auto &table_info = *storage.GetDataTableInfo();
+	auto &table_info = *table_entry.GetStorage().GetDataTableInfo();
 	table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, [&](RTreeIndex &index) {
 		if (index.name == index_name) {
 			rtree_index = &index;
@@ -122,108 +112,88 @@ static optional_ptr<RTreeIndex> TryGetRTreeIndex(ClientContext &context, const s
 		}
 		return false;
 	});
-
 	return rtree_index;
 }
 
 //-------------------------------------------------------------------------
-// Vacuum PRAGMA 
+// EXECUTE - Output the structure of the RTree indexes
 //-------------------------------------------------------------------------
-static void VacuumRTreeIndexPragma(ClientContext &context, const FunctionParameters &parameters) {
-	if (parameters.values.size() != 1) {
-		throw BinderException("Expected one argument for rtree_vacuum_index");
-	}
-	auto &param = parameters.values[0];
-	if (param.type() != LogicalType::VARCHAR) {
-		throw BinderException("Expected a string argument for rtree_vacuum_index");
-	}
-	auto index_name = param.GetValue<string>();
-
-	auto rtree_index = TryGetRTreeIndex(context, index_name);
-	if (!rtree_index) {
-		throw BinderException("RTree Index %s not found", index_name);
-	}
-}
-
-static unique_ptr<FunctionData> DebugAllIndexesBind(ClientContext &context, TableFunctionBindInput &input,
-                                                    vector<LogicalType> &return_types, vector<string> &names) {
-	names.emplace_back("catalog_name");
-	return_types.emplace_back(LogicalType::VARCHAR);
-	
-	names.emplace_back("schema_name");
-	return_types.emplace_back(LogicalType::VARCHAR);
-	
-	names.emplace_back("index_name");
-	return_types.emplace_back(LogicalType::VARCHAR);
-	
-	names.emplace_back("table_name");
-	return_types.emplace_back(LogicalType::VARCHAR);
-	
-	names.emplace_back("index_type");
-	return_types.emplace_back(LogicalType::VARCHAR);
-	
-	return nullptr;
-}
-
-struct DebugAllIndexesGlobalState : public GlobalTableFunctionState {
-	idx_t offset = 0;
-	vector<reference<IndexCatalogEntry>> entries;
-};
-
-static unique_ptr<GlobalTableFunctionState> DebugAllIndexesInitGlobal(ClientContext &context,
-                                                                      TableFunctionInitInput &input) {
-	auto result = make_uniq<DebugAllIndexesGlobalState>();
-
-	auto schemas = Catalog::GetAllSchemas(context);
-	for (auto &schema : schemas) {
-		schema.get().Scan(context, CatalogType::INDEX_ENTRY, [&](CatalogEntry &entry) {
-			auto &index_entry = entry.Cast<IndexCatalogEntry>();
-			result->entries.push_back(index_entry);
-		});
-	}
-	
-	return std::move(result);
-}
-
-static void DebugAllIndexesExecute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-	auto &data = data_p.global_state->Cast<DebugAllIndexesGlobalState>();
-	if (data.offset >= data.entries.size()) {
-		return;
-	}
+static void RTreeIndexInfoExecute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &data = data_p.global_state->Cast<RTreeIndexInfoGlobalState>();
 
 	idx_t row = 0;
 	while (data.offset < data.entries.size() && row < STANDARD_VECTOR_SIZE) {
 		auto &index_entry = data.entries[data.offset++].get();
 		auto &table_entry = index_entry.schema.catalog.GetEntry<TableCatalogEntry>(context, index_entry.GetSchemaName(),
 		                                                                           index_entry.GetTableName());
+		auto rtree_index = TryGetRTreeIndex(context, table_entry, index_entry.name);
+		if (!rtree_index) {
+			continue;
+		}
+
+		// The walk holds only the shared key of the tree, appends to the buffer go on meanwhile
+		const auto stats = rtree_index->GetStats();
+		IndexLock lock;
+		rtree_index->InitializeLock(lock);
+		const auto buffered = rtree_index->GetBufferedCount(lock);
+		const auto memory_usage = rtree_index->GetInMemorySize(lock);
+		const auto space = rtree_index->GetSpace();
+
+		vector<Value> level_nodes;
+		for (auto count : stats.level_nodes) {
+			level_nodes.push_back(Value::BIGINT(NumericCast<int64_t>(count)));
+		}
 
 		idx_t col = 0;
 		output.data[col++].SetValue(row, Value(index_entry.catalog.GetName()));
 		output.data[col++].SetValue(row, Value(index_entry.schema.name));
 		output.data[col++].SetValue(row, Value(index_entry.name));
 		output.data[col++].SetValue(row, Value(table_entry.name));
-		output.data[col++].SetValue(row, Value(index_entry.index_type));
+		output.data[col++].SetValue(row, Value(rtree_index->unbound_expressions[0]->return_type.ToString()));
+		output.data[col++].SetValue(row, Value(space.GetDimensions()));
+		output.data[col++].SetValue(row, space.has_x ? Value::INTEGER(space.srid) : Value(LogicalType::INTEGER));
+		output.data[col++].SetValue(row, Value::BIGINT(NumericCast<int64_t>(stats.level_nodes.size())));
+		output.data[col++].SetValue(row, Value::LIST(LogicalType::BIGINT, std::move(level_nodes)));
+		output.data[col++].SetValue(row, Value::BIGINT(NumericCast<int64_t>(stats.node_count)));
+		output.data[col++].SetValue(row, Value::BIGINT(NumericCast<int64_t>(rtree_index->GetEntryCount())));
+		output.data[col++].SetValue(row, Value::BIGINT(NumericCast<int64_t>(buffered)));
+		output.data[col++].SetValue(row, Value::DOUBLE(stats.fill));
+		output.data[col++].SetValue(row, Value::DOUBLE(stats.dead_space));
+		output.data[col++].SetValue(row, Value::DOUBLE(stats.leaf_overlap));
+		output.data[col++].SetValue(row, Value::BIGINT(NumericCast<int64_t>(memory_usage)));
 
 		row++;
 	}
 	output.SetCardinality(row);
 }
 
+//-------------------------------------------------------------------------
+// Stats PRAGMA - the info row of one index
+//-------------------------------------------------------------------------
+static string RTreeStatsPragma(ClientContext &context, const FunctionParameters &parameters) {
+	// The name may be qualified with the schema, and the catalog before it
+	auto qname = QualifiedName::Parse(parameters.values[0].GetValue<string>());
+	auto query = StringUtil::Format("SELECT * FROM trtree_index_info() WHERE index_name = %s",
+	                                KeywordHelper::WriteQuoted(qname.name, '\''));
+	if (!IsInvalidSchema(qname.schema)) {
+		query += StringUtil::Format(" AND schema_name = %s", KeywordHelper::WriteQuoted(qname.schema, '\''));
+	}
+	if (!IsInvalidCatalog(qname.catalog)) {
+		query += StringUtil::Format(" AND catalog_name = %s", KeywordHelper::WriteQuoted(qname.catalog, '\''));
+	}
+	return query;
+}
 
 //-------------------------------------------------------------------------
 // Register all pragma functions
 //-------------------------------------------------------------------------
-// void RTreeModule::RegisterIndexPragmas(DatabaseInstance &db) {
-// 	ExtensionUtil::RegisterFunction(
-// 	    db, PragmaFunction::PragmaCall("rtree_vacuum_index", VacuumRTreeIndexPragma, {LogicalType::VARCHAR}));
+void RTreeModule::RegisterIndexPragmas(DatabaseInstance &db) {
+	TableFunction info_function("trtree_index_info", {}, RTreeIndexInfoExecute, RTreeIndexInfoBind,
+	                            RTreeIndexInfoInitGlobal);
+	ExtensionUtil::RegisterFunction(db, info_function);
 
-// 	TableFunction info_function("pragma_rtree_index_info", {}, RTreeIndexInfoExecute, RTreeIndexInfoBind,
-// 	                            RTreeIndexInfoInitGlobal);
-// 	ExtensionUtil::RegisterFunction(db, info_function);
-
-//     TableFunction debug_function("debug_all_indexes", {}, DebugAllIndexesExecute, DebugAllIndexesBind,
-// 	                            DebugAllIndexesInitGlobal);
-// 	ExtensionUtil::RegisterFunction(db, debug_function);
-// }
+	ExtensionUtil::RegisterFunction(
+	    db, PragmaFunction::PragmaCall("trtree_stats", RTreeStatsPragma, {LogicalType::VARCHAR}));
+}
 
-} 
\ No newline at end of file
+} // namespace duckdb
@@ -140,6 +140,8 @@ static void LoadInternal(DatabaseInstance &instance) {
   	RTreeModule::RegisterRTreeIndex(instance);
 	RTreeModule::RegisterIndexScan(instance);
 	RTreeModule::RegisterScanOptimizer(instance);
+	RTreeModule::RegisterIndexJoinOptimizer(instance);
+	RTreeModule::RegisterIndexPragmas(instance);
 }
 
 void MobilityduckExtension::Load(DuckDB &db) {
@@ -544,6 +544,36 @@ void TboxType::RegisterScalarFunctions(DatabaseInstance &instance) {
             TboxFunctions::Tbox_expand_time
         )
     );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "&&", // overlaps
+            {TBOX(), TBOX()},
+            LogicalType::BOOLEAN,
+            TboxFunctions::Overlaps_tbox_tbox
+        )
+    );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "@>", // contains
+            {TBOX(), TBOX()},
+            LogicalType::BOOLEAN,
+            TboxFunctions::Contains_tbox_tbox
+        )
+    );
+
+    ExtensionUtil::RegisterFunction(
+        instance,
+        ScalarFunction(
+            "<@", // contained
+            {TBOX(), TBOX()},
+            LogicalType::BOOLEAN,
+            TboxFunctions::Contained_tbox_tbox
+        )
+    );
 }
 
 } // namespace duckdb
\ No newline at end of file
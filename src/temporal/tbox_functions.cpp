@@ -1035,4 +1035,40 @@ void TboxFunctions::Tbox_expand_time(DataChunk &args, ExpressionState &state, Ve
     }
 }
 
+/* ***************************************************
+ * Topological operators
+ ****************************************************/
+
+void TboxFunctions::TboxTopoExecutor(Vector &tbox1, Vector &tbox2, bool (*op)(const TBox *, const TBox *),
+                                     Vector &result, idx_t count) {
+    BinaryExecutor::Execute<string_t, string_t, bool>(
+        tbox1, tbox2, result, count,
+        [&](string_t tbox1_str, string_t tbox2_str) -> bool {
+            if (tbox1_str.GetSize() < sizeof(TBox) || tbox2_str.GetSize() < sizeof(TBox)) {
+                throw InvalidInputException("Invalid TBOX data: insufficient size");
+            }
+            // The blob data is not guaranteed to be aligned
+            TBox box1, box2;
+            memcpy(&box1, tbox1_str.GetData(), sizeof(TBox));
+            memcpy(&box2, tbox2_str.GetData(), sizeof(TBox));
+            return op(&box1, &box2);
+        }
+    );
+    if (count == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+void TboxFunctions::Overlaps_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TboxTopoExecutor(args.data[0], args.data[1], overlaps_tbox_tbox, result, args.size());
+}
+
+void TboxFunctions::Contains_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TboxTopoExecutor(args.data[0], args.data[1], contains_tbox_tbox, result, args.size());
+}
+
+void TboxFunctions::Contained_tbox_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TboxTopoExecutor(args.data[0], args.data[1], contained_tbox_tbox, result, args.size());
+}
+
 } // namespace duckdb
\ No newline at end of file
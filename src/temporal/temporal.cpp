@@ -4,6 +4,7 @@
 #include "temporal/temporal.hpp"
 #include "temporal/temporal_functions.hpp"
 #include "temporal/spanset.hpp"
+#include "temporal/tbox.hpp"
 
 #include "duckdb/common/types/blob.hpp"
 #include "duckdb/common/exception.hpp"
@@ -70,6 +71,15 @@ void TemporalTypes::RegisterCastFunctions(DatabaseInstance &instance) {
             LogicalType::VARCHAR,
             TemporalFunctions::Temporal_out
         );
+
+        if (type.GetAlias() == "TINT" || type.GetAlias() == "TFLOAT") {
+            ExtensionUtil::RegisterCastFunction(
+                instance,
+                type,
+                TboxType::TBOX(),
+                TemporalFunctions::Tnumber_to_tbox_cast
+            );
+        }
     }
 }
 
@@ -419,6 +429,76 @@ void TemporalTypes::RegisterScalarFunctions(DatabaseInstance &instance) {
                     TemporalFunctions::Tnumber_shift_scale_value
                 )
             );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "tbox",
+                    {type},
+                    TboxType::TBOX(),
+                    TemporalFunctions::Tnumber_to_tbox
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "&&", // overlaps
+                    {type, TboxType::TBOX()},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Overlaps_tnumber_tbox
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "@>", // contains
+                    {type, TboxType::TBOX()},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Contains_tnumber_tbox
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "<@", // contained
+                    {type, TboxType::TBOX()},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Contained_tnumber_tbox
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "&&", // overlaps
+                    {TboxType::TBOX(), type},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Overlaps_tbox_tnumber
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "@>", // contains
+                    {TboxType::TBOX(), type},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Contains_tbox_tnumber
+                )
+            );
+
+            ExtensionUtil::RegisterFunction(
+                instance,
+                ScalarFunction(
+                    "<@", // contained
+                    {TboxType::TBOX(), type},
+                    LogicalType::BOOLEAN,
+                    TemporalFunctions::Contained_tbox_tnumber
+                )
+            );
         }
     }
 
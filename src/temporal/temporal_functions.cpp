@@ -364,6 +364,43 @@ void TemporalFunctions::Tnumber_to_span(DataChunk &args, ExpressionState &state,
     }
 }
 
+void TemporalFunctions::TnumberToTboxExecutor(Vector &source, Vector &result, idx_t count) {
+    UnaryExecutor::Execute<string_t, string_t>(
+        source, result, count,
+        [&](string_t input) {
+            const uint8_t *data = reinterpret_cast<const uint8_t*>(input.GetData());
+            size_t data_size = input.GetSize();
+            if (data_size < sizeof(Temporal)) {
+                throw InvalidInputException("Invalid Temporal data: insufficient size");
+            }
+            uint8_t *data_copy = (uint8_t*)malloc(data_size);
+            memcpy(data_copy, data, data_size);
+            Temporal *temp = reinterpret_cast<Temporal*>(data_copy);
+
+            TBox *ret = tnumber_to_tbox(temp);
+            free(temp);
+            if (!ret) {
+                throw InvalidInputException("Failed to convert temporal number to TBOX");
+            }
+            string_t stored_data = StringVector::AddStringOrBlob(result, string_t((char *) ret, sizeof(TBox)));
+            free(ret);
+            return stored_data;
+        }
+    );
+    if (count == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+void TemporalFunctions::Tnumber_to_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberToTboxExecutor(args.data[0], result, args.size());
+}
+
+bool TemporalFunctions::Tnumber_to_tbox_cast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+    TnumberToTboxExecutor(source, result, count);
+    return true;
+}
+
 /* ***************************************************
  * Accessor functions
  ****************************************************/
@@ -1208,4 +1245,62 @@ void TemporalFunctions::Tbool_when_true(DataChunk &args, ExpressionState &state,
     }
 }
 
+/* ***************************************************
+ * Topological operators
+ ****************************************************/
+
+//! Apply a bounding box operator between a temporal number and a TBOX, in either order
+template <bool TBOX_FIRST, typename OP>
+static void TnumberTboxTopoExecutor(DataChunk &args, Vector &result, OP op) {
+    auto &temp_vec = args.data[TBOX_FIRST ? 1 : 0];
+    auto &tbox_vec = args.data[TBOX_FIRST ? 0 : 1];
+    BinaryExecutor::Execute<string_t, string_t, bool>(
+        temp_vec, tbox_vec, result, args.size(),
+        [&](string_t temp_str, string_t tbox_str) -> bool {
+            if (temp_str.GetSize() < sizeof(Temporal) || tbox_str.GetSize() < sizeof(TBox)) {
+                throw InvalidInputException("Invalid Temporal or TBOX data: insufficient size");
+            }
+            uint8_t *temp_copy = (uint8_t*)malloc(temp_str.GetSize());
+            memcpy(temp_copy, temp_str.GetData(), temp_str.GetSize());
+            Temporal *temp = reinterpret_cast<Temporal*>(temp_copy);
+            TBox box;
+            memcpy(&box, tbox_str.GetData(), sizeof(TBox));
+
+            bool ret = op(temp, &box);
+            free(temp);
+            return ret;
+        }
+    );
+    if (args.size() == 1) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+void TemporalFunctions::Overlaps_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<false>(args, result, overlaps_tnumber_tbox);
+}
+
+void TemporalFunctions::Contains_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<false>(args, result, contains_tnumber_tbox);
+}
+
+void TemporalFunctions::Contained_tnumber_tbox(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<false>(args, result, contained_tnumber_tbox);
+}
+
+void TemporalFunctions::Overlaps_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<true>(args, result,
+                                  [](const Temporal *temp, const TBox *box) { return overlaps_tbox_tnumber(box, temp); });
+}
+
+void TemporalFunctions::Contains_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<true>(args, result,
+                                  [](const Temporal *temp, const TBox *box) { return contains_tbox_tnumber(box, temp); });
+}
+
+void TemporalFunctions::Contained_tbox_tnumber(DataChunk &args, ExpressionState &state, Vector &result) {
+    TnumberTboxTopoExecutor<true>(args, result,
+                                  [](const Temporal *temp, const TBox *box) { return contained_tbox_tnumber(box, temp); });
+}
+
 } // namespace duckdb
\ No newline at end of file